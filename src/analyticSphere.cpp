@@ -0,0 +1,142 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: analyticSphere.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "analyticSphere.h"
+#include "triangles.h"
+#include "framebuffer.h"
+#include <cmath>
+#include <algorithm>
+
+SphereCamera prepareSphereCamera(const Uniforms& frame) {
+    SphereCamera camera;
+    camera.view = frame.view;
+    camera.worldFromView = glm::inverse(frame.view);
+    camera.projection = frame.projection;
+    camera.viewport = frame.viewport;
+    // glm::perspective stores -(f + n) / (f - n) and -2fn / (f - n)
+    camera.nearPlane = frame.projection[3][2] / (frame.projection[2][2] - 1.0f);
+    // the viewport maps -1..1 to 0..width, so ndc 1 lands on the width
+    camera.width = frame.viewport[0][0] + frame.viewport[3][0];
+    camera.height = frame.viewport[1][1] + frame.viewport[3][1];
+    return camera;
+}
+
+// ndc extent along one axis of a sphere at offset c across it and depth d ahead of the eye
+static void axisBounds(float c, float depth, float radius, float focal, float& low, float& high) {
+    float distanceSquared = c * c + depth * depth;
+    low = -INFINITY;
+    high = INFINITY;
+    if (distanceSquared <= radius * radius) {
+        return;
+    }
+    float center = std::atan2(c, depth);
+    float halfAngle = std::asin(radius / std::sqrt(distanceSquared));
+    if (center - halfAngle > -glm::half_pi<float>()) {
+        low = focal * std::tan(center - halfAngle);
+    }
+    if (center + halfAngle < glm::half_pi<float>()) {
+        high = focal * std::tan(center + halfAngle);
+    }
+}
+
+bool sphereScreenBounds(const SphereCamera& camera, const glm::vec3& viewCenter, float radius, PixelRect& rect) {
+    float depth = -viewCenter.z;
+    if (depth + radius < camera.nearPlane) {
+        return false;
+    }
+
+    float lowX, highX, lowY, highY;
+    axisBounds(viewCenter.x, depth, radius, camera.projection[0][0], lowX, highX);
+    axisBounds(viewCenter.y, depth, radius, camera.projection[1][1], lowY, highY);
+
+    const glm::mat4& viewport = camera.viewport;
+    float minX = std::max(viewport[0][0] * lowX + viewport[3][0], 0.0f);
+    float maxX = std::min(viewport[0][0] * highX + viewport[3][0], camera.width - 1.0f);
+    float minY = std::max(viewport[1][1] * lowY + viewport[3][1], 0.0f);
+    float maxY = std::min(viewport[1][1] * highY + viewport[3][1], camera.height - 1.0f);
+    rect = PixelRect{
+        static_cast<int>(std::ceil(minX)),
+        static_cast<int>(std::ceil(minY)),
+        static_cast<int>(std::floor(maxX)),
+        static_cast<int>(std::floor(maxY))
+    };
+    return rect.minX <= rect.maxX && rect.minY <= rect.maxY;
+}
+
+// same spherical mapping the generated spheres use
+static glm::vec2 sphericalUV(const glm::vec3& direction) {
+    float u = 0.5f + std::atan2(direction.z, direction.x) / glm::two_pi<float>();
+    float v = 0.5f + std::asin(glm::clamp(direction.y, -1.0f, 1.0f)) / glm::pi<float>();
+    return glm::vec2(u, v);
+}
+
+void sphereFragments(const SphereCamera& camera, const glm::mat4& model, const glm::vec3& center, float radius, std::vector<Fragment>& fragments) {
+    glm::mat3 linear = glm::mat3(model);
+    float scale = std::max(glm::length(linear[0]), std::max(glm::length(linear[1]), glm::length(linear[2])));
+    float worldRadius = radius * scale;
+    glm::vec3 worldCenter = glm::vec3(model * glm::vec4(center, 1.0f));
+    glm::vec3 viewCenter = glm::vec3(camera.view * glm::vec4(worldCenter, 1.0f));
+
+    PixelRect rect;
+    if (!sphereScreenBounds(camera, viewCenter, worldRadius, rect)) {
+        return;
+    }
+
+    glm::mat4 modelFromWorld = glm::inverse(model);
+    const glm::mat4& viewport = camera.viewport;
+    const glm::mat4& projection = camera.projection;
+    float centerSquared = glm::dot(viewCenter, viewCenter) - worldRadius * worldRadius;
+
+    for (int y = rect.minY; y <= rect.maxY; ++y) {
+        float rayY = (y - viewport[3][1]) / viewport[1][1] / projection[1][1];
+        for (int x = rect.minX; x <= rect.maxX; ++x) {
+            // view-space ray through the pixel, with depth 1 per unit of t
+            glm::vec3 ray((x - viewport[3][0]) / viewport[0][0] / projection[0][0], rayY, -1.0f);
+            float a = glm::dot(ray, ray);
+            float b = glm::dot(ray, viewCenter);
+            float discriminant = b * b - a * centerSquared;
+            if (discriminant < 0.0f) {
+                continue;
+            }
+            float t = (b - std::sqrt(discriminant)) / a;
+            if (t < camera.nearPlane) {
+                continue;
+            }
+
+            glm::vec3 worldPos = glm::vec3(camera.worldFromView * glm::vec4(ray * t, 1.0f));
+            glm::vec3 normal = (worldPos - worldCenter) / worldRadius;
+            float intensity = glm::dot(normal, L);
+            if (intensity < 0) {
+                continue;
+            }
+
+            float ndcZ = (projection[2][2] * -t + projection[3][2]) / t;
+            double z = viewport[2][2] * ndcZ + viewport[3][2];
+            glm::vec3 originalPos = glm::vec3(modelFromWorld * glm::vec4(worldPos, 1.0f));
+
+            Color color = Color(255, 255, 255);
+            if (currentTexture) {
+                glm::vec2 texCoords = sphericalUV(glm::normalize(originalPos - center));
+                color = getPixelFromTexture(texCoords.x, texCoords.y);
+            }
+
+            fragments.push_back(
+                Fragment{
+                    static_cast<uint16_t>(x),
+                    static_cast<uint16_t>(y),
+                    z,
+                    color,
+                    intensity,
+                    worldPos,
+                    originalPos
+                }
+            );
+        }
+    }
+}
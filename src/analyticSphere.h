@@ -0,0 +1,41 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: analyticSphere.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "fragment.h"
+#include <vector>
+#include <glm/glm.hpp>
+
+// per-frame camera data for casting rays at spheres; the projection has to be
+// a symmetric perspective like the one glm::perspective builds
+struct SphereCamera {
+    glm::mat4 view;
+    glm::mat4 worldFromView;
+    glm::mat4 projection;
+    glm::mat4 viewport;
+    float nearPlane;  // distance from the eye
+    float width;      // of the target, from the viewport
+    float height;
+};
+
+SphereCamera prepareSphereCamera(const Uniforms& frame);
+
+// inclusive pixel rectangle, already clamped to the target
+struct PixelRect {
+    int minX, minY, maxX, maxY;
+};
+
+// bounding square of a view-space sphere on screen, from the planes through the
+// eye tangent to it; false when none of it is on screen or in front of the near plane
+bool sphereScreenBounds(const SphereCamera& camera, const glm::vec3& viewCenter, float radius, PixelRect& rect);
+
+// intersects the ray of every pixel in the sphere's bounds with the sphere and
+// appends a fragment with exact depth, normal, worldPos and originalPos for the
+// ones it hits; center and radius are in model space
+void sphereFragments(const SphereCamera& camera, const glm::mat4& model, const glm::vec3& center, float radius, std::vector<Fragment>& fragments);
@@ -0,0 +1,354 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: bodyBvh.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "bodyBvh.h"
+#include "jobSystem.h"
+#include "morton.h"
+#include <cmath>
+#include <algorithm>
+
+// below this many bodies a subtree isn't worth a job of its own
+constexpr uint32_t PARALLEL_BUILD_MIN = 16384;
+
+// deep enough for any tree of halved ranges over 32-bit counts
+constexpr size_t STACK_SIZE = 64;
+
+// per axis; the codes only have to order bodies roughly, and 30 bits sort in
+// half the passes of the full 63
+constexpr int CODE_BITS = 10;
+
+static glm::vec4 bodySphere(const Scene& scene, uint32_t body) {
+    const MeshView& mesh = scene.meshes[scene.mesh[body]];
+    const glm::mat4& model = scene.model[body];
+    glm::vec4 center = model[0] * mesh.boundsCenter.x + model[1] * mesh.boundsCenter.y + model[2] * mesh.boundsCenter.z + model[3];
+    return glm::vec4(glm::vec3(center), mesh.boundsRadius * scene.scale[body]);
+}
+
+static float surfaceArea(const BvhNode& node) {
+    glm::vec3 size = node.max - node.min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+static void fitLeaf(BvhNode& node, const glm::vec4* spheres) {
+    node.min = glm::vec3(INFINITY);
+    node.max = glm::vec3(-INFINITY);
+    for (uint32_t slot = node.first; slot < node.first + node.count; ++slot) {
+        glm::vec3 center = glm::vec3(spheres[slot]);
+        node.min = glm::min(node.min, center - spheres[slot].w);
+        node.max = glm::max(node.max, center + spheres[slot].w);
+    }
+}
+
+// nodes of a tree over count bodies, every range being split in half
+static uint32_t subtreeNodes(uint32_t count) {
+    return count <= BVH_LEAF_SIZE ? 1 : 1 + subtreeNodes(count / 2) + subtreeNodes(count - count / 2);
+}
+
+// fills the node and its subtree over the slots [first, first + count), which
+// are already in Morton order; returns the index after the subtree
+static uint32_t buildNode(BvhNode* nodes, const glm::vec4* spheres, uint32_t index, uint32_t first, uint32_t count) {
+    BvhNode& node = nodes[index];
+    node.first = first;
+    node.count = count;
+    node.right = 0;
+    if (count <= BVH_LEAF_SIZE) {
+        fitLeaf(node, spheres);
+        return index + 1;
+    }
+
+    uint32_t half = count / 2;
+    uint32_t end;
+    // the sizes of the subtrees are known up front, so both halves can be built
+    // at once; each is a job an idle thread can take, down to where that's worth it
+    if (count >= PARALLEL_BUILD_MIN) {
+        node.right = index + 1 + subtreeNodes(half);
+        parallelFor(2, 1, [&](size_t side, size_t sideEnd) {
+            for (; side < sideEnd; ++side) {
+                if (side == 0) {
+                    buildNode(nodes, spheres, index + 1, first, half);
+                } else {
+                    end = buildNode(nodes, spheres, node.right, first + half, count - half);
+                }
+            }
+        });
+    } else {
+        node.right = buildNode(nodes, spheres, index + 1, first, half);
+        end = buildNode(nodes, spheres, node.right, first + half, count - half);
+    }
+    node.min = glm::min(nodes[index + 1].min, nodes[node.right].min);
+    node.max = glm::max(nodes[index + 1].max, nodes[node.right].max);
+    return end;
+}
+
+void buildBodyBvh(BodyBvh& bvh, const Scene& scene) {
+    uint32_t count = static_cast<uint32_t>(scene.size());
+    bvh.bodySpheres.resize(count);
+    glm::vec3 low(INFINITY), high(-INFINITY);
+    for (uint32_t body = 0; body < count; ++body) {
+        bvh.bodySpheres[body] = bodySphere(scene, body);
+        low = glm::min(low, glm::vec3(bvh.bodySpheres[body]));
+        high = glm::max(high, glm::vec3(bvh.bodySpheres[body]));
+    }
+
+    // sorting by Morton code puts bodies close in space next to each other, so
+    // halving a range of slots splits space about in half along one of the axes
+    float width = std::max(std::max(high.x - low.x, high.y - low.y), std::max(high.z - low.z, 1e-6f));
+    float quantize = ((1 << CODE_BITS) - 1) / width;
+    bvh.codes.resize(count);
+    bvh.bodies.resize(count);
+    for (uint32_t body = 0; body < count; ++body) {
+        glm::vec3 cell = (glm::vec3(bvh.bodySpheres[body]) - low) * quantize;
+        bvh.codes[body] = mortonCode(static_cast<uint64_t>(cell.x), static_cast<uint64_t>(cell.y), static_cast<uint64_t>(cell.z));
+        bvh.bodies[body] = body;
+    }
+    radixSortCodes(bvh.codes, bvh.bodies, bvh.codeScratch, bvh.orderScratch);
+
+    bvh.slots.resize(count);
+    bvh.spheres.resize(count);
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        bvh.slots[bvh.bodies[slot]] = slot;
+        bvh.spheres[slot] = bvh.bodySpheres[bvh.bodies[slot]];
+    }
+
+    bvh.nodes.resize(count == 0 ? 0 : subtreeNodes(count));
+    if (count > 0) {
+        buildNode(bvh.nodes.data(), bvh.spheres.data(), 0, 0, count);
+    }
+
+    bvh.builtArea = 0.0f;
+    for (const BvhNode& node : bvh.nodes) {
+        bvh.builtArea += surfaceArea(node);
+    }
+    bvh.area = bvh.builtArea;
+    bvh.refits = 0;
+    ++bvh.builds;
+}
+
+// children come after their parent, so walking the nodes backwards refits
+// every child before its parent. the scene is read in body order, which is
+// the order it is stored in
+static void refitBodyBvh(BodyBvh& bvh, const Scene& scene) {
+    for (uint32_t body = 0; body < bvh.slots.size(); ++body) {
+        bvh.spheres[bvh.slots[body]] = bodySphere(scene, body);
+    }
+    float area = 0.0f;
+    for (size_t index = bvh.nodes.size(); index-- > 0;) {
+        BvhNode& node = bvh.nodes[index];
+        if (node.right == 0) {
+            fitLeaf(node, bvh.spheres.data());
+        } else {
+            const BvhNode& left = bvh.nodes[index + 1];
+            const BvhNode& right = bvh.nodes[node.right];
+            node.min = glm::min(left.min, right.min);
+            node.max = glm::max(left.max, right.max);
+        }
+        area += surfaceArea(node);
+    }
+    bvh.area = area;
+    ++bvh.refits;
+}
+
+bool updateBodyBvh(BodyBvh& bvh, const Scene& scene) {
+    if (bvh.bodies.size() != scene.size() || bvh.refits >= bvh.rebuildInterval) {
+        buildBodyBvh(bvh, scene);
+        return true;
+    }
+    refitBodyBvh(bvh, scene);
+    if (bvh.area > bvh.builtArea * bvh.maxGrowth) {
+        buildBodyBvh(bvh, scene);
+        return true;
+    }
+    return false;
+}
+
+void frustumPlanes(const Uniforms& frame, glm::vec4 planes[6]) {
+    glm::mat4 clipFromWorld = frame.projection * frame.view;
+    // planes of the clip volume -w <= x, y, z <= w
+    glm::vec4 w = glm::vec4(clipFromWorld[0][3], clipFromWorld[1][3], clipFromWorld[2][3], clipFromWorld[3][3]);
+    for (int axis = 0; axis < 3; ++axis) {
+        glm::vec4 row = glm::vec4(clipFromWorld[0][axis], clipFromWorld[1][axis], clipFromWorld[2][axis], clipFromWorld[3][axis]);
+        planes[2 * axis] = w + row;
+        planes[2 * axis + 1] = w - row;
+    }
+    for (int k = 0; k < 6; ++k) {
+        planes[k] /= glm::length(glm::vec3(planes[k]));
+    }
+}
+
+void queryFrustum(const BodyBvh& bvh, const Scene& scene, const glm::vec4 planes[6], std::vector<uint32_t>& slots) {
+    slots.clear();
+    if (bvh.nodes.empty()) {
+        return;
+    }
+    uint32_t stack[STACK_SIZE];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        uint32_t index = stack[--top];
+        const BvhNode& node = bvh.nodes[index];
+        glm::vec3 center = (node.min + node.max) * 0.5f;
+        glm::vec3 extent = (node.max - node.min) * 0.5f;
+        bool outside = false;
+        bool inside = true;
+        for (int k = 0; k < 6 && !outside; ++k) {
+            float distance = glm::dot(glm::vec3(planes[k]), center) + planes[k].w;
+            float reach = glm::dot(glm::abs(glm::vec3(planes[k])), extent);
+            outside = distance < -reach;
+            inside = inside && distance >= reach;
+        }
+        if (outside) {
+            continue;
+        }
+
+        // a box inside every plane has every sphere of the subtree inside too
+        if (inside || node.right == 0) {
+            for (uint32_t slot = node.first; slot < node.first + node.count; ++slot) {
+                if (!scene.visible[bvh.bodies[slot]]) {
+                    continue;
+                }
+                bool inFrustum = true;
+                for (int k = 0; k < 6 && inFrustum && !inside; ++k) {
+                    inFrustum = glm::dot(glm::vec3(planes[k]), glm::vec3(bvh.spheres[slot])) + planes[k].w >= -bvh.spheres[slot].w;
+                }
+                if (inFrustum) {
+                    slots.push_back(slot);
+                }
+            }
+            continue;
+        }
+        stack[top++] = node.right;
+        stack[top++] = index + 1;
+    }
+}
+
+// where the ray enters the box, if it does before maxDistance
+static bool rayBox(const BvhNode& node, const glm::vec3& origin, const glm::vec3& inverse, float maxDistance, float& enter) {
+    glm::vec3 t0 = (node.min - origin) * inverse;
+    glm::vec3 t1 = (node.max - origin) * inverse;
+    glm::vec3 lower = glm::min(t0, t1);
+    glm::vec3 upper = glm::max(t0, t1);
+    enter = std::max(std::max(lower.x, lower.y), std::max(lower.z, 0.0f));
+    float exit = std::min(std::min(upper.x, upper.y), std::min(upper.z, maxDistance));
+    return enter <= exit;
+}
+
+bool raycastBodies(const BodyBvh& bvh, const Scene& scene, const glm::vec3& origin, const glm::vec3& direction, BodyHit& hit) {
+    if (bvh.nodes.empty()) {
+        return false;
+    }
+    glm::vec3 inverse = 1.0f / direction;
+    float best = INFINITY;
+    uint32_t bestBody = UINT32_MAX;
+
+    uint32_t stack[STACK_SIZE];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        uint32_t index = stack[--top];
+        const BvhNode& node = bvh.nodes[index];
+        float enter;
+        // boxes are tested again when popped, the best hit may have moved closer since
+        if (!rayBox(node, origin, inverse, best, enter)) {
+            continue;
+        }
+        if (node.right == 0) {
+            for (uint32_t slot = node.first; slot < node.first + node.count; ++slot) {
+                uint32_t body = bvh.bodies[slot];
+                if (!scene.visible[body]) {
+                    continue;
+                }
+                glm::vec3 offset = glm::vec3(bvh.spheres[slot]) - origin;
+                float radius = bvh.spheres[slot].w;
+                float along = glm::dot(offset, direction);
+                float across2 = glm::dot(offset, offset) - along * along;
+                if (across2 > radius * radius) {
+                    continue;
+                }
+                float half = std::sqrt(radius * radius - across2);
+                // from inside the sphere the ray hits it on the way out
+                float t = along - half >= 0.0f ? along - half : along + half;
+                if (t >= 0.0f && t < best) {
+                    best = t;
+                    bestBody = body;
+                }
+            }
+            continue;
+        }
+
+        // the nearer child is popped first
+        float leftEnter, rightEnter;
+        bool left = rayBox(bvh.nodes[index + 1], origin, inverse, best, leftEnter);
+        bool right = rayBox(bvh.nodes[node.right], origin, inverse, best, rightEnter);
+        if (left && right) {
+            bool leftFirst = leftEnter <= rightEnter;
+            stack[top++] = leftFirst ? node.right : index + 1;
+            stack[top++] = leftFirst ? index + 1 : node.right;
+        } else if (left) {
+            stack[top++] = index + 1;
+        } else if (right) {
+            stack[top++] = node.right;
+        }
+    }
+
+    if (bestBody == UINT32_MAX) {
+        return false;
+    }
+    hit.body = bestBody;
+    hit.distance = best;
+    return true;
+}
+
+// from the point to the box, 0 inside it; never more than to any sphere in it
+static float boxDistance(const BvhNode& node, const glm::vec3& point) {
+    glm::vec3 outside = glm::max(glm::max(node.min - point, point - node.max), glm::vec3(0.0f));
+    return glm::length(outside);
+}
+
+bool nearestBody(const BodyBvh& bvh, const Scene& scene, const glm::vec3& point, uint32_t exclude, BodyHit& hit) {
+    if (bvh.nodes.empty()) {
+        return false;
+    }
+    float best = INFINITY;
+    uint32_t bestBody = UINT32_MAX;
+
+    uint32_t stack[STACK_SIZE];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        uint32_t index = stack[--top];
+        const BvhNode& node = bvh.nodes[index];
+        if (boxDistance(node, point) >= best) {
+            continue;
+        }
+        if (node.right == 0) {
+            for (uint32_t slot = node.first; slot < node.first + node.count; ++slot) {
+                uint32_t body = bvh.bodies[slot];
+                if (body == exclude || !scene.visible[body]) {
+                    continue;
+                }
+                float distance = std::max(glm::length(glm::vec3(bvh.spheres[slot]) - point) - bvh.spheres[slot].w, 0.0f);
+                if (distance < best) {
+                    best = distance;
+                    bestBody = body;
+                }
+            }
+            continue;
+        }
+        bool leftFirst = boxDistance(bvh.nodes[index + 1], point) <= boxDistance(bvh.nodes[node.right], point);
+        stack[top++] = leftFirst ? node.right : index + 1;
+        stack[top++] = leftFirst ? index + 1 : node.right;
+    }
+
+    if (bestBody == UINT32_MAX) {
+        return false;
+    }
+    hit.body = bestBody;
+    hit.distance = best;
+    return true;
+}
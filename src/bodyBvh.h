@@ -0,0 +1,79 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: bodyBvh.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "scene.h"
+#include "fragment.h"
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// bodies per leaf at most
+constexpr size_t BVH_LEAF_SIZE = 4;
+
+// box of a subtree, in depth-first order: the left child follows its parent.
+// the bodies of any subtree are one range of slots
+struct BvhNode {
+    glm::vec3 min;
+    uint32_t first;   // first slot
+    glm::vec3 max;
+    uint32_t count;   // slots in the subtree
+    uint32_t right;   // index of the right child, 0 for a leaf
+};
+
+// bounding volume hierarchy over the bodies' bounding spheres; refit as they
+// move and rebuilt now and then, when refitting has loosened it too much.
+// slots follow the bodies' Morton order, and every node splits its range in half
+struct BodyBvh {
+    std::vector<BvhNode> nodes;
+    std::vector<uint32_t> bodies;     // body index by slot
+    std::vector<uint32_t> slots;      // slot by body index
+    std::vector<glm::vec4> spheres;   // center and radius by slot, as of the last refit
+
+    size_t rebuildInterval = 240;     // refits between rebuilds at most
+    float maxGrowth = 1.5f;           // or sooner, once the boxes' total area grew this much
+
+    float builtArea = 0.0f;           // total area of the boxes right after the last build
+    float area = 0.0f;                // and after the last refit
+    size_t refits = 0;                // since the last build
+    size_t builds = 0;
+
+    // kept for rebuilds
+    std::vector<uint64_t> codes;
+    std::vector<uint64_t> codeScratch;
+    std::vector<uint32_t> orderScratch;
+    std::vector<glm::vec4> bodySpheres;
+};
+
+struct BodyHit {
+    uint32_t body = UINT32_MAX;
+    float distance = 0.0f;  // along the ray, or to the surface of the bounding sphere, 0 inside it
+};
+
+// builds the tree from scratch over every body of the scene where it is now;
+// the subtrees of the top levels are filled in parallel
+void buildBodyBvh(BodyBvh& bvh, const Scene& scene);
+
+// fits the tree to where the bodies are now, or rebuilds it when it's due or
+// the scene changed size; true when it was rebuilt
+bool updateBodyBvh(BodyBvh& bvh, const Scene& scene);
+
+// the six clip planes of the frame in world space, pointing inwards and
+// normalized so they give distances
+void frustumPlanes(const Uniforms& frame, glm::vec4 planes[6]);
+
+// the slots of every visible body whose bounding sphere is at least partly
+// inside the planes, ascending; bodies and spheres give what is in them
+void queryFrustum(const BodyBvh& bvh, const Scene& scene, const glm::vec4 planes[6], std::vector<uint32_t>& slots);
+
+// the visible body whose bounding sphere the ray hits first; direction is unit
+bool raycastBodies(const BodyBvh& bvh, const Scene& scene, const glm::vec3& origin, const glm::vec3& direction, BodyHit& hit);
+
+// the visible body, other than exclude, whose bounding sphere's surface is nearest the point
+bool nearestBody(const BodyBvh& bvh, const Scene& scene, const glm::vec3& point, uint32_t exclude, BodyHit& hit);
@@ -0,0 +1,131 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: bodyCulling.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "bodyCulling.h"
+#include "triangles.h"
+#include "meshLod.h"
+#include "bodyBvh.h"
+#include <cmath>
+#include <algorithm>
+
+// true when b's cone fits inside the covered part of a's and all of b is further
+// than a's center, so every ray towards b hits a first
+static bool hides(const OccluderCone& a, const BodyCone& b) {
+    if (a.sine < b.sine || b.distance - b.radius < a.distance) {
+        return false;
+    }
+    // angle between the centers <= a's half angle - b's half angle, compared as cosines
+    return glm::dot(a.direction, b.direction) >= a.cosine * b.cosine + a.sine * b.sine;
+}
+
+// lit points of a sphere are the ones whose normal is within 90 degrees of L;
+// the cone keeps to the normals within 90 degrees - angle(toward eye, L) of the
+// one facing the eye, less a margin for mesh normals that aren't exactly the sphere's
+static bool occluderCone(const BodyCone& body, float innerRadius, OccluderCone& occluder) {
+    const float margin = 0.1f;
+    float lightAngle = std::acos(glm::clamp(glm::dot(-body.direction, L), -1.0f, 1.0f));
+    float normalAngle = glm::half_pi<float>() - lightAngle - margin;
+    if (normalAngle <= 0.0f || body.distance <= innerRadius) {
+        return false;
+    }
+
+    // the point with that normal, seen from the eye, unless that is past the silhouette
+    float silhouette = innerRadius / body.distance;
+    float across = innerRadius * std::sin(normalAngle);
+    float along = body.distance - innerRadius * std::cos(normalAngle);
+    if (std::cos(normalAngle) <= silhouette) {
+        across = innerRadius;
+        along = std::sqrt(body.distance * body.distance - innerRadius * innerRadius);
+    }
+    float hypotenuse = std::sqrt(across * across + along * along);
+    occluder.direction = body.direction;
+    occluder.distance = body.distance;
+    occluder.sine = across / hypotenuse;
+    occluder.cosine = along / hypotenuse;
+    return true;
+}
+
+BodyCullStats cullBodies(const Scene& scene, const BodyBvh& bvh, const Uniforms& frame, std::vector<uint32_t>& visibleBodies, BodyCullScratch& scratch) {
+    BodyCullStats stats;
+    visibleBodies.clear();
+    scratch.cones.clear();
+
+    glm::vec3 eye = glm::vec3(glm::inverse(frame.view)[3]);
+    glm::vec4 planes[6];
+    frustumPlanes(frame, planes);
+    queryFrustum(bvh, scene, planes, scratch.inFrustum);
+    size_t visibleCount = std::count_if(scene.visible.begin(), scene.visible.end(), [](uint8_t visible) { return visible != 0; });
+    stats.outside = visibleCount - scratch.inFrustum.size();
+
+    // the bodies largest on screen, biggest first, are the occluder candidates
+    uint32_t candidates[MAX_OCCLUDERS];
+    size_t candidateCount = 0;
+
+    // the tree's copy of the spheres is read in slot order, the scene isn't touched
+    for (uint32_t slot : scratch.inFrustum) {
+        glm::vec3 center = glm::vec3(bvh.spheres[slot]);
+        float radius = bvh.spheres[slot].w;
+
+        glm::vec3 offset = center - eye;
+        float distance = glm::length(offset);
+        BodyCone cone;
+        cone.direction = offset / std::max(distance, 1e-20f);
+        cone.distance = distance;
+        cone.radius = radius;
+        // with the eye inside the sphere the cone covers everything and can't be hidden
+        cone.sine = distance > radius ? radius / distance : 1.0f;
+        cone.cosine = distance > radius ? std::sqrt(1.0f - cone.sine * cone.sine) : -1.0f;
+
+        uint32_t index = static_cast<uint32_t>(scratch.cones.size());
+        scratch.cones.push_back(cone);
+        // an occluder clipped by the near or far plane has holes in it
+        bool clipped = glm::dot(glm::vec3(planes[4]), center) + planes[4].w < radius
+            || glm::dot(glm::vec3(planes[5]), center) + planes[5].w < radius;
+        if (clipped || (candidateCount == MAX_OCCLUDERS && scratch.cones[candidates[MAX_OCCLUDERS - 1]].sine >= cone.sine)) {
+            continue;
+        }
+        size_t rank = std::min(candidateCount, MAX_OCCLUDERS - 1);
+        while (rank > 0 && scratch.cones[candidates[rank - 1]].sine < cone.sine) {
+            candidates[rank] = candidates[rank - 1];
+            --rank;
+        }
+        candidates[rank] = index;
+        candidateCount = std::min(candidateCount + 1, MAX_OCCLUDERS);
+    }
+
+    OccluderCone occluders[MAX_OCCLUDERS];
+    uint32_t occluderIndex[MAX_OCCLUDERS];
+    size_t occluderCount = 0;
+    for (size_t k = 0; k < candidateCount; ++k) {
+        // the level it will be drawn with, the coarse ones cover less
+        uint32_t body = bvh.bodies[scratch.inFrustum[candidates[k]]];
+        const MeshView& mesh = scene.meshes[scene.mesh[body]];
+        Uniforms uniforms = frame;
+        uniforms.model = scene.model[body];
+        size_t level = selectLod(mesh, projectedRadius(mesh, uniforms));
+        float innerRadius = scene.meshInnerRadius[scene.mesh[body]][level] * scene.scale[body];
+        if (occluderCone(scratch.cones[candidates[k]], innerRadius, occluders[occluderCount])) {
+            occluderIndex[occluderCount++] = candidates[k];
+        }
+    }
+
+    for (uint32_t index = 0; index < scratch.cones.size(); ++index) {
+        const BodyCone& cone = scratch.cones[index];
+        bool hidden = false;
+        for (size_t k = 0; k < occluderCount && !hidden; ++k) {
+            hidden = occluderIndex[k] != index && hides(occluders[k], cone);
+        }
+        if (hidden) {
+            ++stats.occluded;
+        } else {
+            visibleBodies.push_back(bvh.bodies[scratch.inFrustum[index]]);
+        }
+    }
+    return stats;
+}
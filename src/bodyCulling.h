@@ -0,0 +1,53 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: bodyCulling.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "scene.h"
+#include "fragment.h"
+#include "bodyBvh.h"
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// the largest bodies on screen are the only ones tested as occluders
+constexpr size_t MAX_OCCLUDERS = 8;
+
+// a body's bounding sphere as seen from the eye: the cone tangent to it
+struct BodyCone {
+    glm::vec3 direction;  // unit, eye to center
+    float distance;       // eye to center
+    float radius;
+    float sine;           // of the cone's half angle, radius / distance
+    float cosine;
+};
+
+// the part of a body's cone sure to be covered when it is drawn: the inner ball
+// of its mesh, and only where that is lit, the dark side isn't drawn
+struct OccluderCone {
+    glm::vec3 direction;
+    float distance;
+    float sine;
+    float cosine;
+};
+
+struct BodyCullStats {
+    size_t outside = 0;   // out of the frustum
+    size_t occluded = 0;  // inside the disc of a nearer body
+};
+
+// kept between frames so culling doesn't allocate
+struct BodyCullScratch {
+    std::vector<uint32_t> inFrustum;  // slots of the tree
+    std::vector<BodyCone> cones;
+};
+
+// every visible body of the scene whose bounding sphere is in the frustum and
+// not hidden behind another body goes to visibleBodies, in the order of the
+// tree, which has to be up to date with the scene
+BodyCullStats cullBodies(const Scene& scene, const BodyBvh& bvh, const Uniforms& frame, std::vector<uint32_t>& visibleBodies, BodyCullScratch& scratch);
@@ -0,0 +1,125 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: clipping.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "clipping.h"
+#include <utility>
+
+enum ClipPlane {
+    NEAR_PLANE = 1 << 0,   // z >= -w
+    LEFT_GUARD = 1 << 1,   // x >= -GUARD_BAND * w
+    RIGHT_GUARD = 1 << 2,  // x <= GUARD_BAND * w
+    BOTTOM_GUARD = 1 << 3, // y >= -GUARD_BAND * w
+    TOP_GUARD = 1 << 4     // y <= GUARD_BAND * w
+};
+
+constexpr int CLIP_PLANE_COUNT = 5;
+
+// signed distance to a plane, inside when >= 0
+static float planeDistance(int plane, const glm::vec4& p) {
+    switch (plane) {
+        case NEAR_PLANE: return p.z + p.w;
+        case LEFT_GUARD: return p.x + GUARD_BAND * p.w;
+        case RIGHT_GUARD: return GUARD_BAND * p.w - p.x;
+        case BOTTOM_GUARD: return p.y + GUARD_BAND * p.w;
+        default: return GUARD_BAND * p.w - p.y;
+    }
+}
+
+// frustum sides a vertex is outside of; a triangle with every vertex outside
+// the same side can't reach the screen
+static int frustumOutcode(const glm::vec4& p) {
+    int code = 0;
+    code |= (p.x < -p.w) << 0;
+    code |= (p.x > p.w) << 1;
+    code |= (p.y < -p.w) << 2;
+    code |= (p.y > p.w) << 3;
+    code |= (p.z < -p.w) << 4;
+    code |= (p.z > p.w) << 5;
+    return code;
+}
+
+static int clipOutcode(const glm::vec4& p) {
+    int code = 0;
+    for (int bit = 0; bit < CLIP_PLANE_COUNT; ++bit) {
+        if (planeDistance(1 << bit, p) < 0.0f) {
+            code |= 1 << bit;
+        }
+    }
+    return code;
+}
+
+static ClipVertex lerp(const ClipVertex& a, const ClipVertex& b, float t) {
+    return ClipVertex{
+        a.clip + (b.clip - a.clip) * t,
+        a.normal + (b.normal - a.normal) * t,
+        a.tex + (b.tex - a.tex) * t,
+        a.worldPos + (b.worldPos - a.worldPos) * t,
+        a.originalPos + (b.originalPos - a.originalPos) * t
+    };
+}
+
+size_t clipTriangle(const ClipVertex (&triangle)[3], ClipVertex (&polygon)[MAX_CLIPPED_VERTICES]) {
+    if ((frustumOutcode(triangle[0].clip) & frustumOutcode(triangle[1].clip) & frustumOutcode(triangle[2].clip)) != 0) {
+        return 0;
+    }
+
+    int crossed = clipOutcode(triangle[0].clip) | clipOutcode(triangle[1].clip) | clipOutcode(triangle[2].clip);
+    size_t count = 3;
+    for (size_t i = 0; i < 3; ++i) {
+        polygon[i] = triangle[i];
+    }
+    if (crossed == 0) {
+        return count;
+    }
+
+    // Sutherland-Hodgman, only against the planes some vertex is outside of
+    ClipVertex scratch[MAX_CLIPPED_VERTICES];
+    ClipVertex* input = polygon;
+    ClipVertex* output = scratch;
+    for (int bit = 0; bit < CLIP_PLANE_COUNT && count > 0; ++bit) {
+        int plane = 1 << bit;
+        if ((crossed & plane) == 0) {
+            continue;
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const ClipVertex& current = input[i];
+            const ClipVertex& next = input[(i + 1) % count];
+            float currentDistance = planeDistance(plane, current.clip);
+            float nextDistance = planeDistance(plane, next.clip);
+            if (currentDistance >= 0.0f) {
+                output[kept++] = current;
+            }
+            if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+                output[kept++] = lerp(current, next, currentDistance / (currentDistance - nextDistance));
+            }
+        }
+        count = kept;
+        std::swap(input, output);
+    }
+
+    if (input != polygon) {
+        for (size_t i = 0; i < count; ++i) {
+            polygon[i] = input[i];
+        }
+    }
+    return count < 3 ? 0 : count;
+}
+
+Vertex toScreen(const ClipVertex& vertex, const glm::mat4& viewport) {
+    glm::vec3 ndc = glm::vec3(vertex.clip) / vertex.clip.w;
+    return Vertex{
+        glm::vec3(viewport * glm::vec4(ndc, 1.0f)),
+        vertex.normal,
+        vertex.tex,
+        vertex.worldPos,
+        vertex.originalPos
+    };
+}
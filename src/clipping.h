@@ -0,0 +1,37 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: clipping.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "fragment.h"
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// triangles reaching further than this many half-screens past the center in
+// x or y are clipped; anything inside is left to the scissored rasterizer
+constexpr float GUARD_BAND = 8.0f;
+
+// near plane plus the four guard-band planes, each adding at most one vertex
+constexpr size_t MAX_CLIPPED_VERTICES = 3 + 5;
+
+// vertex before the perspective divide; every attribute is linear in clip space
+struct ClipVertex {
+    glm::vec4 clip;
+    glm::vec3 normal;
+    glm::vec2 tex;
+    glm::vec3 worldPos;
+    glm::vec3 originalPos;
+};
+
+// clips a triangle against the near plane, and against the guard band only when
+// it crosses it; returns the vertex count of the resulting convex polygon, 0 when
+// nothing is left or the triangle is entirely outside one side of the frustum
+size_t clipTriangle(const ClipVertex (&triangle)[3], ClipVertex (&polygon)[MAX_CLIPPED_VERTICES]);
+
+// perspective divide and viewport transform
+Vertex toScreen(const ClipVertex& vertex, const glm::mat4& viewport);
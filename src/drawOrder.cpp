@@ -0,0 +1,77 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: drawOrder.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "drawOrder.h"
+#include <cstring>
+#include <algorithm>
+
+static uint32_t floatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+void sortFrontToBack(const Scene& scene, const Uniforms& frame, std::vector<uint32_t>& bodies, DrawOrderScratch& scratch) {
+    size_t count = bodies.size();
+    scratch.keys.resize(count);
+    scratch.keyScratch.resize(count);
+    scratch.bodyScratch.resize(count);
+
+    // the bits of a positive float grow with it, about logarithmically, so the
+    // ones between the near and the far plane shifted into 16 bits make a key
+    // with the same relative precision close up and far away
+    float nearPlane = frame.projection[3][2] / (frame.projection[2][2] - 1.0f);
+    float farPlane = frame.projection[3][2] / (frame.projection[2][2] + 1.0f);
+    uint32_t nearBits = floatBits(nearPlane);
+    uint32_t range = floatBits(farPlane) - nearBits;
+    int shift = 0;
+    while ((range >> shift) > UINT16_MAX) {
+        ++shift;
+    }
+
+    glm::vec4 depthRow = -glm::vec4(frame.view[0][2], frame.view[1][2], frame.view[2][2], frame.view[3][2]);
+    uint32_t histograms[2][256] = {};
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t body = bodies[i];
+        const MeshView& mesh = scene.meshes[scene.mesh[body]];
+        const glm::mat4& model = scene.model[body];
+        // column by column, which compiles to much less than glm's mat4 * vec4
+        glm::vec4 center = model[0] * mesh.boundsCenter.x + model[1] * mesh.boundsCenter.y + model[2] * mesh.boundsCenter.z + model[3];
+        float depth = glm::dot(depthRow, center) - mesh.boundsRadius * scene.scale[body];
+        depth = glm::clamp(depth, nearPlane, farPlane);
+        uint16_t key = static_cast<uint16_t>((floatBits(depth) - nearBits) >> shift);
+        scratch.keys[i] = key;
+        ++histograms[0][key & 0xff];
+        ++histograms[1][key >> 8];
+    }
+
+    // least significant byte first; each pass is stable, so the second keeps
+    // the order of the first within equal high bytes
+    for (int pass = 0; pass < 2; ++pass) {
+        uint32_t* histogram = histograms[pass];
+        if (std::find(histogram, histogram + 256, static_cast<uint32_t>(count)) != histogram + 256) {
+            continue;  // every key has the same byte here, nothing would move
+        }
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; ++bucket) {
+            uint32_t size = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += size;
+        }
+        int byteShift = pass * 8;
+        for (size_t i = 0; i < count; ++i) {
+            uint16_t key = scratch.keys[i];
+            uint32_t slot = histogram[(key >> byteShift) & 0xff]++;
+            scratch.keyScratch[slot] = key;
+            scratch.bodyScratch[slot] = bodies[i];
+        }
+        scratch.keys.swap(scratch.keyScratch);
+        bodies.swap(scratch.bodyScratch);
+    }
+}
@@ -0,0 +1,26 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: drawOrder.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "scene.h"
+#include "fragment.h"
+#include <vector>
+#include <cstdint>
+
+// kept between frames so sorting doesn't allocate
+struct DrawOrderScratch {
+    std::vector<uint16_t> keys;
+    std::vector<uint16_t> keyScratch;
+    std::vector<uint32_t> bodyScratch;
+};
+
+// reorders the bodies nearest first, by the view depth of the front of their
+// bounding spheres, so later draws fail the early depth test behind earlier
+// ones. bodies at the same quantized depth keep their order
+void sortFrontToBack(const Scene& scene, const Uniforms& frame, std::vector<uint32_t>& bodies, DrawOrderScratch& scratch);
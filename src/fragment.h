@@ -47,7 +47,7 @@ struct FragColor {
 struct Vertex {
   glm::vec3 position;
   glm::vec3 normal;
-  glm::vec3 tex;
+  glm::vec2 tex;
   glm::vec3 worldPos;
   glm::vec3 originalPos;
 };
\ No newline at end of file
@@ -0,0 +1,71 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: framePipeline.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "framePipeline.h"
+
+// frames are prepared strictly one after the other, each one needs the
+// scene as the one before left it
+static void prepareFrames(FramePipeline& pipeline) {
+    for (size_t frame = 0;; ++frame) {
+        {
+            std::unique_lock<std::mutex> lock(pipeline.mutex);
+            pipeline.changed.wait(lock, [&] { return pipeline.stopping || frame - pipeline.released < frameSlots(pipeline); });
+            if (pipeline.stopping) {
+                return;
+            }
+        }
+        pipeline.prepare(frame % frameSlots(pipeline));
+        {
+            std::lock_guard<std::mutex> lock(pipeline.mutex);
+            pipeline.prepared = frame + 1;
+        }
+        pipeline.changed.notify_all();
+    }
+}
+
+void startFramePipeline(FramePipeline& pipeline, size_t depth, std::function<void(size_t slot)> prepare) {
+    pipeline.depth = depth;
+    pipeline.prepare = std::move(prepare);
+    pipeline.prepared = 0;
+    pipeline.released = 0;
+    pipeline.stopping = false;
+    if (depth > 0) {
+        pipeline.preparer = std::thread(prepareFrames, std::ref(pipeline));
+    }
+}
+
+size_t acquireFrame(FramePipeline& pipeline) {
+    if (pipeline.depth == 0) {
+        pipeline.prepare(0);
+        ++pipeline.prepared;
+        return 0;
+    }
+    std::unique_lock<std::mutex> lock(pipeline.mutex);
+    pipeline.changed.wait(lock, [&] { return pipeline.prepared > pipeline.released; });
+    return pipeline.released % frameSlots(pipeline);
+}
+
+void releaseFrame(FramePipeline& pipeline) {
+    {
+        std::lock_guard<std::mutex> lock(pipeline.mutex);
+        ++pipeline.released;
+    }
+    pipeline.changed.notify_all();
+}
+
+void stopFramePipeline(FramePipeline& pipeline) {
+    {
+        std::lock_guard<std::mutex> lock(pipeline.mutex);
+        pipeline.stopping = true;
+    }
+    pipeline.changed.notify_all();
+    if (pipeline.preparer.joinable()) {
+        pipeline.preparer.join();
+    }
+}
@@ -0,0 +1,45 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: framePipeline.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <cstddef>
+
+// frames prepared on a thread of their own, at most depth of them ahead of the
+// one being drawn, in depth + 1 slots; the frame drawn is then up to depth
+// frames older than the newest input. depth 0 prepares each frame on the
+// drawing thread right before it is drawn
+struct FramePipeline {
+    size_t depth = 1;
+    std::function<void(size_t slot)> prepare;
+
+    std::thread preparer;
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t prepared = 0;  // frames finished by prepare
+    size_t released = 0;  // frames done drawing, whose slot can be prepared again
+    bool stopping = false;
+};
+
+// starts preparing frames into the slots, from slot 0 on
+void startFramePipeline(FramePipeline& pipeline, size_t depth, std::function<void(size_t slot)> prepare);
+
+// waits for the next frame and returns its slot, which stays untouched until released
+size_t acquireFrame(FramePipeline& pipeline);
+void releaseFrame(FramePipeline& pipeline);
+
+// waits for the frame being prepared, if any, and stops
+void stopFramePipeline(FramePipeline& pipeline);
+
+inline size_t frameSlots(const FramePipeline& pipeline) {
+    return pipeline.depth + 1;
+}
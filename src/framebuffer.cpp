@@ -8,6 +8,7 @@ Last modification: 23/11/2023
 *Some parts were made using the AIs Bard and ChatGPT
 ------------------------------------------------------------------------------*/
 #include "framebuffer.h"
+#include "jobSystem.h"
 
 FragColor blank{
     Color{0, 0, 0},
@@ -29,30 +30,36 @@ void clearFramebuffer() {
     std::fill(framebuffer.begin(), framebuffer.end(), blank);
 }
 
-void renderBuffer(SDL_Renderer* renderer) {
-    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
+// pixels something was drawn to since the last clear
+size_t coveredPixels() {
+    return std::count_if(framebuffer.begin(), framebuffer.end(), [](const FragColor& pixel) { return pixel.z != blank.z; });
+}
 
-    void* texturePixels;
-    int pitch;
-    SDL_LockTexture(texture, NULL, &texturePixels, &pitch);
+RenderTarget::RenderTarget(size_t targetWidth, size_t targetHeight)
+    : width(targetWidth), height(targetHeight), pixels(targetWidth * targetHeight, blank) {
+}
 
-    Uint32 format = SDL_PIXELFORMAT_ARGB8888;
-    SDL_PixelFormat* mappingFormat = SDL_AllocFormat(format);
+void RenderTarget::clear() {
+    std::fill(pixels.begin(), pixels.end(), blank);
+}
 
-    Uint32* texturePixels32 = static_cast<Uint32*>(texturePixels);
-    for (int y = 0; y < SCREEN_HEIGHT; y++) {
-        for (int x = 0; x < SCREEN_WIDTH; x++) {
-            int framebufferY = SCREEN_HEIGHT - y - 1; // Reverse the order of rows
-            int index = y * (pitch / sizeof(Uint32)) + x;
-            const Color& color = framebuffer[framebufferY * SCREEN_WIDTH + x].color;
-            texturePixels32[index] = SDL_MapRGBA(mappingFormat, color.r, color.g, color.b, color.a);
-        }
+void copyToFramebuffer(const RenderTarget& target, size_t x, size_t y) {
+    size_t columns = std::min(target.width, SCREEN_WIDTH - std::min(x, SCREEN_WIDTH));
+    size_t rows = std::min(target.height, SCREEN_HEIGHT - std::min(y, SCREEN_HEIGHT));
+    for (size_t row = 0; row < rows; ++row) {
+        const FragColor* source = &target.pixels[row * target.width];
+        std::copy(source, source + columns, &framebuffer[(y + row) * SCREEN_WIDTH + x]);
     }
+}
 
-    SDL_UnlockTexture(texture);
-    SDL_Rect textureRect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
-    SDL_RenderCopy(renderer, texture, NULL, &textureRect);
-    SDL_DestroyTexture(texture);
-
-    SDL_RenderPresent(renderer);
+void resolveFramebuffer(Color* colors) {
+    // rows are copied by separate jobs, each writes only its own
+    parallelFor(SCREEN_HEIGHT, 32, [&](size_t firstRow, size_t endRow) {
+        for (size_t y = firstRow; y < endRow; ++y) {
+            const FragColor* row = &framebuffer[(SCREEN_HEIGHT - y - 1) * SCREEN_WIDTH];  // Reverse the order of rows
+            for (size_t x = 0; x < SCREEN_WIDTH; ++x) {
+                colors[y * SCREEN_WIDTH + x] = row[x].color;
+            }
+        }
+    });
 }
@@ -13,6 +13,7 @@ Last modification: 23/11/2023
 #include <array>
 #include <limits>
 #include <mutex>
+#include <vector>
 #include <algorithm>
 #include <glm/glm.hpp>
 #include <SDL2/SDL.h>
@@ -24,6 +25,23 @@ extern FragColor blank;
 extern std::array<FragColor, SCREEN_WIDTH * SCREEN_HEIGHT> framebuffer;
 extern std::array<std::mutex, SCREEN_WIDTH * SCREEN_HEIGHT> mutexes;
 
+// color and depth of a view that doesn't draw straight to the screen, copied
+// into the framebuffer once it is done
+struct RenderTarget {
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<FragColor> pixels;  // rows bottom up, like the framebuffer
+
+    RenderTarget() = default;
+    RenderTarget(size_t targetWidth, size_t targetHeight);
+    void clear();
+};
+
 void point(Fragment f);
 void clearFramebuffer();
-void renderBuffer(SDL_Renderer* renderer);
+size_t coveredPixels();
+// the whole target into the framebuffer, its lower left corner at x, y
+void copyToFramebuffer(const RenderTarget& target, size_t x, size_t y);
+// the framebuffer's colors, rows top down as the screen has them, for presenting
+// while the framebuffer is drawn again
+void resolveFramebuffer(Color* colors);
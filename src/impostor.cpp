@@ -0,0 +1,209 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: impostor.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "impostor.h"
+#include "analyticSphere.h"
+#include "framebuffer.h"
+#include "shaders.h"
+#include <cmath>
+#include <algorithm>
+
+constexpr size_t TILE_TEXELS = IMPOSTOR_TILE_SIZE * IMPOSTOR_TILE_SIZE;
+
+ImpostorAtlas::ImpostorAtlas() {
+    texels.resize(IMPOSTOR_TILE_COUNT * TILE_TEXELS);
+    freeTiles.reserve(IMPOSTOR_TILE_COUNT);
+    for (size_t tile = IMPOSTOR_TILE_COUNT; tile-- > 0;) {
+        freeTiles.push_back(static_cast<uint32_t>(tile));
+    }
+}
+
+void beginImpostorFrame(ImpostorAtlas& atlas) {
+    for (Impostor& impostor : atlas.impostors) {
+        if (impostor.tile != UINT32_MAX && impostor.lastUsed != atlas.frame) {
+            atlas.freeTiles.push_back(impostor.tile);
+            impostor.tile = UINT32_MAX;
+        }
+    }
+    ++atlas.frame;
+    atlas.refreshesLeft = atlas.refreshBudget;
+}
+
+// one small body this frame
+struct Sprite {
+    const Instance* instance;
+    glm::vec2 center;       // pixels
+    double centerDepth;     // screen z of the center
+    float radius;           // pixels
+    PixelRect rect;
+    glm::vec3 modelDirection;
+    glm::vec3 worldDirection;
+    float staleness;        // radians the view turned since the bake, INFINITY when it has to be baked
+};
+
+static float angleBetween(const glm::vec3& a, const glm::vec3& b) {
+    return std::acos(glm::clamp(glm::dot(a, b), -1.0f, 1.0f));
+}
+
+// texel of the tile the pixel at offset (x, y) from the body's center falls on
+static int texelIndex(float x, float y, float texelsPerPixel, const glm::vec2& center) {
+    int tx = static_cast<int>(std::floor(x * texelsPerPixel + center.x + 0.5f));
+    int ty = static_cast<int>(std::floor(y * texelsPerPixel + center.y + 0.5f));
+    if (tx < 0 || ty < 0 || tx >= IMPOSTOR_TILE_SIZE || ty >= IMPOSTOR_TILE_SIZE) {
+        return -1;
+    }
+    return ty * IMPOSTOR_TILE_SIZE + tx;
+}
+
+// shades the body where it is now into its tile, one texel per pixel; the tile is
+// aligned to the pixel grid so a sprite that didn't move is drawn exactly as baked
+static void bakeImpostor(RenderContext& context, ImpostorAtlas& atlas, const SphereCamera& camera, const MeshView& mesh, const Sprite& sprite) {
+    Impostor& impostor = atlas.impostors[sprite.instance->id];
+    ImpostorTexel* tile = &atlas.texels[impostor.tile * TILE_TEXELS];
+    std::fill(tile, tile + TILE_TEXELS, ImpostorTexel{Color(), INFINITY});
+
+    glm::vec2 origin = glm::floor(sprite.center) - glm::vec2(IMPOSTOR_TILE_SIZE / 2.0f);
+    SphereCamera tileCamera = camera;
+    tileCamera.viewport[3][0] = camera.viewport[3][0] - origin.x;
+    tileCamera.viewport[3][1] = camera.viewport[3][1] - origin.y;
+
+    context.fragments.clear();
+    sphereFragments(tileCamera, sprite.instance->model, mesh.boundsCenter, mesh.boundsRadius, context.fragments);
+    context.shaded.clear();
+    for (const Fragment& fragment : context.fragments) {
+        if (fragment.x < IMPOSTOR_TILE_SIZE && fragment.y < IMPOSTOR_TILE_SIZE) {
+            context.shaded.push_back(fragment);
+        }
+    }
+    shadeFragments(context.shaded, sprite.instance->shader);
+    for (const Fragment& shaded : context.shaded) {
+        tile[shaded.y * IMPOSTOR_TILE_SIZE + shaded.x] = ImpostorTexel{shaded.color, static_cast<float>(shaded.z - sprite.centerDepth)};
+    }
+
+    impostor.shader = sprite.instance->shader;
+    impostor.modelDirection = sprite.modelDirection;
+    impostor.worldDirection = sprite.worldDirection;
+    impostor.radius = sprite.radius;
+    impostor.center = sprite.center - origin;
+}
+
+// scales the sprite to the body's current size; depth offsets shrink with the
+// square of the distance like the depth range of the body does
+static void blitImpostor(RenderContext& context, const ImpostorAtlas& atlas, const Sprite& sprite) {
+    const Impostor& impostor = atlas.impostors[sprite.instance->id];
+    const ImpostorTexel* tile = &atlas.texels[impostor.tile * TILE_TEXELS];
+    float texelsPerPixel = impostor.radius / sprite.radius;
+    float depthScale = (sprite.radius / impostor.radius) * (sprite.radius / impostor.radius);
+
+    for (int y = sprite.rect.minY; y <= sprite.rect.maxY; ++y) {
+        for (int x = sprite.rect.minX; x <= sprite.rect.maxX; ++x) {
+            int texel = texelIndex(x - sprite.center.x, y - sprite.center.y, texelsPerPixel, impostor.center);
+            if (texel < 0 || tile[texel].depth == INFINITY) {
+                continue;
+            }
+            Fragment fragment;
+            fragment.x = static_cast<uint16_t>(x);
+            fragment.y = static_cast<uint16_t>(y);
+            fragment.z = sprite.centerDepth + tile[texel].depth * depthScale;
+            fragment.color = tile[texel].color;
+            plot(context, fragment);
+        }
+    }
+}
+
+void drawImpostors(RenderContext& context, ImpostorAtlas& atlas, const MeshView& mesh, Span<Instance> instances, const Uniforms& frame, std::vector<Instance>& remaining) {
+    SphereCamera camera = prepareSphereCamera(frame);
+    glm::vec3 eye = glm::vec3(camera.worldFromView[3]);
+    glm::mat4 clipFromWorld = frame.projection * frame.view;
+    float pixelsPerUnit = frame.projection[1][1] * frame.viewport[1][1];
+
+    std::vector<Sprite> sprites;
+    sprites.reserve(instances.size());
+    for (const Instance& instance : instances) {
+        if (instance.id >= atlas.impostors.size()) {
+            atlas.impostors.resize(instance.id + 1);
+        }
+
+        glm::mat3 linear = glm::mat3(instance.model);
+        float scale = std::max(glm::length(linear[0]), std::max(glm::length(linear[1]), glm::length(linear[2])));
+        float worldRadius = mesh.boundsRadius * scale;
+        glm::vec3 worldCenter = glm::vec3(instance.model * glm::vec4(mesh.boundsCenter, 1.0f));
+        glm::vec3 viewCenter = glm::vec3(camera.view * glm::vec4(worldCenter, 1.0f));
+        float depth = -viewCenter.z;
+        if (depth - worldRadius <= camera.nearPlane || worldRadius * pixelsPerUnit / depth > atlas.maxRadius) {
+            remaining.push_back(instance);
+            continue;
+        }
+
+        Sprite sprite;
+        sprite.instance = &instance;
+        sprite.radius = worldRadius * pixelsPerUnit / depth;
+        if (!sphereScreenBounds(camera, viewCenter, worldRadius, sprite.rect)) {
+            ++context.stats.culledInstances;
+            continue;
+        }
+        glm::vec4 clip = clipFromWorld * glm::vec4(worldCenter, 1.0f);
+        glm::vec3 screen = glm::vec3(frame.viewport * glm::vec4(glm::vec3(clip) / clip.w, 1.0f));
+        sprite.center = glm::vec2(screen);
+        sprite.centerDepth = screen.z;
+        sprite.worldDirection = glm::normalize(eye - worldCenter);
+        glm::vec3 modelEye = glm::vec3(glm::inverse(instance.model) * glm::vec4(eye, 1.0f));
+        sprite.modelDirection = glm::normalize(modelEye - mesh.boundsCenter);
+
+        const Impostor& impostor = atlas.impostors[instance.id];
+        if (impostor.tile == UINT32_MAX || impostor.shader != instance.shader) {
+            sprite.staleness = INFINITY;
+        } else {
+            sprite.staleness = std::max(
+                angleBetween(sprite.modelDirection, impostor.modelDirection),
+                angleBetween(sprite.worldDirection, impostor.worldDirection)
+            );
+            if (sprite.radius > impostor.radius * atlas.maxScale) {
+                sprite.staleness = std::max(sprite.staleness, atlas.maxAngle * sprite.radius / impostor.radius);
+            }
+        }
+        sprites.push_back(sprite);
+    }
+
+    // the stalest sprites within the budget are re-shaded, missing ones first
+    atlas.refreshOrder.clear();
+    for (uint32_t i = 0; i < sprites.size(); ++i) {
+        if (sprites[i].staleness > atlas.maxAngle) {
+            atlas.refreshOrder.push_back(i);
+        }
+    }
+    size_t refreshes = std::min(atlas.refreshesLeft, atlas.refreshOrder.size());
+    atlas.refreshesLeft -= refreshes;
+    auto stalest = [&](uint32_t a, uint32_t b) { return sprites[a].staleness > sprites[b].staleness; };
+    std::nth_element(atlas.refreshOrder.begin(), atlas.refreshOrder.begin() + refreshes, atlas.refreshOrder.end(), stalest);
+    for (size_t r = 0; r < refreshes; ++r) {
+        const Sprite& sprite = sprites[atlas.refreshOrder[r]];
+        Impostor& impostor = atlas.impostors[sprite.instance->id];
+        if (impostor.tile == UINT32_MAX) {
+            if (atlas.freeTiles.empty()) {
+                continue;
+            }
+            impostor.tile = atlas.freeTiles.back();
+            atlas.freeTiles.pop_back();
+        }
+        bakeImpostor(context, atlas, camera, mesh, sprite);
+        ++context.stats.impostorRefreshes;
+    }
+
+    for (const Sprite& sprite : sprites) {
+        Impostor& impostor = atlas.impostors[sprite.instance->id];
+        if (impostor.tile == UINT32_MAX || impostor.shader != sprite.instance->shader) {
+            remaining.push_back(*sprite.instance);
+            continue;
+        }
+        impostor.lastUsed = atlas.frame;
+        blitImpostor(context, atlas, sprite);
+        ++context.stats.impostors;
+    }
+}
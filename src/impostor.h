@@ -0,0 +1,60 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: impostor.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "mesh.h"
+#include "renderer.h"
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// texels per side of a sprite; bodies up to half of it in screen radius use one
+constexpr int IMPOSTOR_TILE_SIZE = 32;
+constexpr size_t IMPOSTOR_TILE_COUNT = 2048;
+
+struct ImpostorTexel {
+    Color color;
+    float depth;  // screen z relative to the body's center, INFINITY where uncovered
+};
+
+struct Impostor {
+    uint32_t tile = UINT32_MAX;  // UINT32_MAX = none
+    shaderType shader = shaderType::Earth;
+    glm::vec3 modelDirection;    // towards the eye when baked, in model space
+    glm::vec3 worldDirection;    // same in world space, the light is fixed there
+    float radius = 0.0f;         // on screen when baked, in pixels
+    glm::vec2 center;            // of the body within the tile, in texels
+    uint32_t lastUsed = 0;
+};
+
+// pre-shaded color + depth sprites of small bodies in one shared atlas; only a
+// budget of them is re-shaded each frame, the ones that changed angle most first
+struct ImpostorAtlas {
+    std::vector<ImpostorTexel> texels;  // IMPOSTOR_TILE_COUNT tiles, one after the other
+    std::vector<uint32_t> freeTiles;
+    std::vector<Impostor> impostors;    // by Instance::id
+    std::vector<uint32_t> refreshOrder;
+    uint32_t frame = 0;
+    size_t refreshesLeft = 0;           // of the budget, this frame
+
+    size_t refreshBudget = 64;                  // bakes per frame
+    float maxRadius = IMPOSTOR_TILE_SIZE / 2.0f;
+    float maxAngle = glm::radians(3.0f);        // staleness before a sprite is worth refreshing
+    float maxScale = 1.25f;                     // growth before the sprite gets blurry
+
+    ImpostorAtlas();
+};
+
+// starts a frame: tiles of bodies that weren't drawn as sprites last frame go back to the pool
+void beginImpostorFrame(ImpostorAtlas& atlas);
+
+// draws every instance small enough on screen from its sprite and refreshes what
+// is left of the frame's budget on its stalest sprites; the rest, and any small one that has no sprite
+// yet, is appended to remaining for one of the full draws
+void drawImpostors(RenderContext& context, ImpostorAtlas& atlas, const MeshView& mesh, Span<Instance> instances, const Uniforms& frame, std::vector<Instance>& remaining);
@@ -0,0 +1,343 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: jobSystem.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "jobSystem.h"
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// the queue of the running thread in the system it works for; threads that
+// aren't one of its workers share queue 0
+static thread_local const JobSystem* currentSystem = nullptr;
+static thread_local size_t currentQueue = 0;
+
+static size_t queueOf(const JobSystem& system) {
+    return currentSystem == &system ? currentQueue : 0;
+}
+
+#if defined(__linux__)
+static void pinThread(pthread_t thread, size_t core) {
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    CPU_SET(core % std::max(1u, std::thread::hardware_concurrency()), &cores);
+    pthread_setaffinity_np(thread, sizeof(cores), &cores);
+}
+#endif
+
+static void pushJob(JobSystem& system, size_t queue, const Job& job) {
+    {
+        std::lock_guard<std::mutex> lock(system.queues[queue]->mutex);
+        system.queues[queue]->jobs.push_back(job);
+    }
+    system.queued.fetch_add(1);
+    // sleepers check queued holding the mutex, so once it is taken here they
+    // either saw the job or are waiting for the notification
+    if (system.sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(system.sleepMutex);
+        system.wake.notify_one();
+    }
+}
+
+// the thread's own newest job, or else the oldest job of another thread
+static bool popJob(JobSystem& system, size_t self, Job& job) {
+    if (system.queued.load() == 0) {
+        return false;
+    }
+    size_t count = system.queues.size();
+    for (size_t k = 0; k < count; ++k) {
+        JobQueue& queue = *system.queues[(self + k) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) {
+            continue;
+        }
+        if (k == 0) {
+            job = queue.jobs.back();
+            queue.jobs.pop_back();
+        } else {
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+            system.stats.steals.fetch_add(1, std::memory_order_relaxed);
+        }
+        system.queued.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+static bool queueEmpty(JobSystem& system, size_t self) {
+    JobQueue& queue = *system.queues[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    return queue.jobs.empty();
+}
+
+// lazy binary splitting: before each grain of the range, half of what is left
+// goes to the queue if the queue is empty, so there is always something to
+// steal while this thread works and ranges get no smaller than stealing needs
+static void runJob(JobSystem& system, size_t self, Job job) {
+    bool canSplit = system.threadCount() > 1;
+    while (job.begin < job.end) {
+        if (canSplit && job.end - job.begin > job.grain && queueEmpty(system, self)) {
+            size_t middle = job.begin + (job.end - job.begin) / 2;
+            Job other = job;
+            other.begin = middle;
+            job.end = middle;
+            job.counter->pending.fetch_add(1);
+            pushJob(system, self, other);
+            system.stats.splits.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        size_t end = std::min(job.end, job.begin + job.grain);
+        job.function(job.context, job.begin, end);
+        system.stats.jobs.fetch_add(1, std::memory_order_relaxed);
+        job.begin = end;
+    }
+    job.counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+static void workerLoop(JobSystem& system, size_t self) {
+    currentSystem = &system;
+    currentQueue = self;
+    // a short spin before sleeping, jobs tend to come in bursts within a frame
+    const int spins = 64;
+    int idle = 0;
+    while (!system.stopping.load()) {
+        Job job;
+        if (popJob(system, self, job)) {
+            runJob(system, self, job);
+            idle = 0;
+            continue;
+        }
+        if (++idle < spins) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(system.sleepMutex);
+        system.sleepers.fetch_add(1);
+        system.wake.wait(lock, [&] { return system.queued.load() > 0 || system.stopping.load(); });
+        system.sleepers.fetch_sub(1);
+        idle = 0;
+    }
+}
+
+JobSystem::JobSystem(const JobSystemSettings& settings) {
+    size_t threads = settings.threadCount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : settings.threadCount;
+    for (size_t k = 0; k < threads; ++k) {
+        queues.emplace_back(new JobQueue());
+    }
+#if defined(__linux__)
+    if (settings.pinThreads) {
+        pinThread(pthread_self(), 0);
+    }
+#endif
+    for (size_t k = 1; k < threads; ++k) {
+        workers.emplace_back(workerLoop, std::ref(*this), k);
+#if defined(__linux__)
+        if (settings.pinThreads) {
+            pinThread(workers.back().native_handle(), k);
+        }
+#endif
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping.store(true);
+        wake.notify_all();
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+static std::mutex sharedMutex;
+static std::unique_ptr<JobSystem> sharedSystem;
+static std::atomic<JobSystem*> sharedPointer{nullptr};
+static JobSystemSettings sharedSettings;
+
+JobSystem& jobSystem() {
+    JobSystem* system = sharedPointer.load(std::memory_order_acquire);
+    if (system) {
+        return *system;
+    }
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    if (!sharedSystem) {
+        sharedSystem.reset(new JobSystem(sharedSettings));
+        sharedPointer.store(sharedSystem.get(), std::memory_order_release);
+    }
+    return *sharedSystem;
+}
+
+void configureJobSystem(const JobSystemSettings& settings) {
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    sharedSettings = settings;
+    if (sharedSystem) {
+        sharedPointer.store(nullptr);
+        sharedSystem.reset();
+    }
+}
+
+void waitForJobs(JobSystem& system, JobCounter& counter) {
+    size_t self = queueOf(system);
+    while (counter.pending.load(std::memory_order_acquire) > 0) {
+        Job job;
+        if (popJob(system, self, job)) {
+            runJob(system, self, job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void parallelForRange(JobSystem& system, size_t count, size_t grain, void (*function)(void* context, size_t begin, size_t end), void* context) {
+    grain = std::max<size_t>(grain, 1);
+    if (count == 0) {
+        return;
+    }
+    if (system.threadCount() == 1 || count <= grain) {
+        function(context, 0, count);
+        return;
+    }
+    JobCounter counter;
+    counter.pending.store(1);
+    Job job;
+    job.function = function;
+    job.context = context;
+    job.end = count;
+    job.grain = grain;
+    job.counter = &counter;
+    runJob(system, queueOf(system), job);
+    waitForJobs(system, counter);
+}
+
+uint32_t addTask(TaskGraph& graph, std::function<void()> task) {
+    graph.tasks.push_back(std::move(task));
+    graph.successors.emplace_back();
+    graph.predecessors.push_back(0);
+    graph.waiting.reset();
+    return static_cast<uint32_t>(graph.tasks.size() - 1);
+}
+
+void addDependency(TaskGraph& graph, uint32_t before, uint32_t after) {
+    graph.successors[before].push_back(after);
+    ++graph.predecessors[after];
+}
+
+struct TaskRun {
+    JobSystem* system;
+    TaskGraph* graph;
+    JobCounter* counter;
+};
+
+static Job taskJob(TaskRun& run, uint32_t task) {
+    Job job;
+    job.function = [](void* context, size_t begin, size_t) {
+        TaskRun& run = *static_cast<TaskRun*>(context);
+        TaskGraph& graph = *run.graph;
+        graph.tasks[begin]();
+        for (uint32_t next : graph.successors[begin]) {
+            if (graph.waiting[next].fetch_sub(1) == 1) {
+                pushJob(*run.system, queueOf(*run.system), taskJob(run, next));
+            }
+        }
+    };
+    job.context = &run;
+    job.begin = task;
+    job.end = task + 1;
+    job.counter = run.counter;
+    return job;
+}
+
+void runTaskGraph(JobSystem& system, TaskGraph& graph) {
+    size_t count = graph.tasks.size();
+    if (count == 0) {
+        return;
+    }
+    if (!graph.waiting) {
+        graph.waiting.reset(new std::atomic<uint32_t>[count]);
+    }
+    for (size_t task = 0; task < count; ++task) {
+        graph.waiting[task].store(graph.predecessors[task]);
+    }
+
+    // every task counts once, the ones started by others included
+    JobCounter counter;
+    counter.pending.store(count);
+    TaskRun run{&system, &graph, &counter};
+    for (uint32_t task = 0; task < count; ++task) {
+        if (graph.predecessors[task] == 0) {
+            pushJob(system, queueOf(system), taskJob(run, task));
+        }
+    }
+    waitForJobs(system, counter);
+}
+
+// median of a few runs, in nanoseconds
+template <typename Work>
+static double timeRuns(const Work& work) {
+    const int runs = 7;
+    double times[runs];
+    for (int run = 0; run < runs; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        work();
+        times[run] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::nth_element(times, times + runs / 2, times + runs);
+    return times[runs / 2];
+}
+
+void benchmarkJobs(const JobSystemSettings& settings) {
+    JobSystem system(settings);
+    std::cout << "Jobs: " << system.threadCount() << " threads" << (settings.pinThreads ? ", pinned" : "") << std::endl;
+
+    // a square root per index: the difference to the serial loop over the
+    // ranges it was cut into is what scheduling one range costs
+    const size_t count = 1 << 20;
+    std::vector<float> values(count);
+    auto body = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            values[i] = std::sqrt(static_cast<float>(i));
+        }
+    };
+    double serial = timeRuns([&] { body(0, count); });
+    // threads beyond the cores take turns, they don't add time
+    double cores = static_cast<double>(std::min<size_t>(system.threadCount(), std::max(1u, std::thread::hardware_concurrency())));
+    std::cout << "  serial loop: " << serial / count << " ns per index" << std::endl;
+    for (size_t grain : {16, 256, 4096, 65536}) {
+        uint64_t jobsBefore = system.stats.jobs.load();
+        uint64_t stealsBefore = system.stats.steals.load();
+        double parallel = timeRuns([&] { parallelFor(system, count, grain, body); });
+        double ranges = static_cast<double>(system.stats.jobs.load() - jobsBefore) / 7;
+        double steals = static_cast<double>(system.stats.steals.load() - stealsBefore) / 7;
+        std::cout << "  parallelFor grain " << grain << ": " << parallel / count << " ns per index, "
+            << serial / parallel << "x the serial loop, " << ranges << " ranges, " << steals << " steals, "
+            << (ranges > 0 ? (parallel * cores - serial) / ranges : 0.0) << " ns of overhead per range" << std::endl;
+    }
+
+    // empty tasks, side by side and one after the other
+    const uint32_t tasks = 10000;
+    TaskGraph independent;
+    TaskGraph chain;
+    for (uint32_t task = 0; task < tasks; ++task) {
+        addTask(independent, [] {});
+        addTask(chain, [] {});
+        if (task > 0) {
+            addDependency(chain, task - 1, task);
+        }
+    }
+    double side = timeRuns([&] { runTaskGraph(system, independent); });
+    double after = timeRuns([&] { runTaskGraph(system, chain); });
+    std::cout << "  task graph: " << side / tasks << " ns per independent task, "
+        << after / tasks << " ns per task in a chain" << std::endl;
+}
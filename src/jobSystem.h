@@ -0,0 +1,123 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: jobSystem.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+struct JobSystemSettings {
+    unsigned int threadCount = 0;  // counting the thread that waits, 0 = one per hardware thread
+    bool pinThreads = false;       // thread k stays on core k
+};
+
+// jobs not finished yet; whoever waits on it runs jobs until it gets to zero,
+// so waiting inside a job doesn't tie up a thread
+struct JobCounter {
+    std::atomic<size_t> pending{0};
+};
+
+// a range of indices for one function; ranges larger than grain are split in
+// half whenever the thread running them has nothing else queued
+struct Job {
+    void (*function)(void* context, size_t begin, size_t end) = nullptr;
+    void* context = nullptr;
+    size_t begin = 0;
+    size_t end = 0;
+    size_t grain = 1;
+    JobCounter* counter = nullptr;
+};
+
+// one per thread: its owner pushes and pops at the back, where the jobs are
+// still warm in its cache, and the others steal from the front, where the big
+// halves of the earliest splits are
+struct JobQueue {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+};
+
+// counted since the system started; the benchmark reads them
+struct JobSystemStats {
+    std::atomic<uint64_t> jobs{0};
+    std::atomic<uint64_t> splits{0};
+    std::atomic<uint64_t> steals{0};
+};
+
+// a fixed set of worker threads sharing work by stealing it
+struct JobSystem {
+    std::vector<std::unique_ptr<JobQueue>> queues;  // by thread; 0 is shared by every thread that isn't a worker
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> sleepers{0};
+    std::atomic<bool> stopping{false};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    JobSystemStats stats;
+
+    explicit JobSystem(const JobSystemSettings& settings = JobSystemSettings());
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    size_t threadCount() const { return queues.size(); }
+};
+
+// the system every stage shares, started on first use
+JobSystem& jobSystem();
+
+// settings for the shared system; restarts it if it was already running, so it
+// must not be called while jobs are
+void configureJobSystem(const JobSystemSettings& settings);
+
+// runs jobs, the thread's own first and then stolen ones, until nothing is left
+// to do for the counter
+void waitForJobs(JobSystem& system, JobCounter& counter);
+
+// function over [0, count) in ranges of at least grain indices, split only as
+// far as idle threads ask for; returns when every range is done
+void parallelForRange(JobSystem& system, size_t count, size_t grain, void (*function)(void* context, size_t begin, size_t end), void* context);
+
+// body(begin, end) over [0, count); body may call parallelFor itself
+template <typename Body>
+void parallelFor(JobSystem& system, size_t count, size_t grain, const Body& body) {
+    parallelForRange(system, count, grain, [](void* context, size_t begin, size_t end) {
+        (*static_cast<const Body*>(context))(begin, end);
+    }, const_cast<Body*>(&body));
+}
+
+template <typename Body>
+void parallelFor(size_t count, size_t grain, const Body& body) {
+    parallelFor(jobSystem(), count, grain, body);
+}
+
+// tasks that may only start once every task they depend on is done; built once
+// and run as often as needed. dependencies must not form a cycle
+struct TaskGraph {
+    std::vector<std::function<void()>> tasks;
+    std::vector<std::vector<uint32_t>> successors;
+    std::vector<uint32_t> predecessors;
+    std::unique_ptr<std::atomic<uint32_t>[]> waiting;  // predecessors left during a run
+};
+
+uint32_t addTask(TaskGraph& graph, std::function<void()> task);
+void addDependency(TaskGraph& graph, uint32_t before, uint32_t after);
+
+// runs every task once, each as soon as the tasks before it are done
+void runTaskGraph(JobSystem& system, TaskGraph& graph);
+
+// cost of scheduling per job and per task next to serial loops, at the
+// configured thread count
+void benchmarkJobs(const JobSystemSettings& settings);
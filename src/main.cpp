@@ -15,7 +15,20 @@ Last modification: 23/11/2023
 #include "fragment.h"
 #include "triangles.h"
 #include "framebuffer.h"
-#include "triangleFill.h"
+#include "meshLod.h"
+#include "meshCache.h"
+#include "scene.h"
+#include "renderer.h"
+#include "impostor.h"
+#include "nbody.h"
+#include "bodyBvh.h"
+#include "bodyCulling.h"
+#include "drawOrder.h"
+#include "simulationClock.h"
+#include "jobSystem.h"
+#include "framePipeline.h"
+#include "presentQueue.h"
+#include "sphereGenerator.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_events.h>
 #include <iostream>
@@ -24,13 +37,16 @@ Last modification: 23/11/2023
 #include <sstream>
 #include <vector>
 #include <cassert>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <unistd.h>
 
 Color currentColor;
-bool sunPresent = false;
-bool moonPresent = false;
 SDL_Window* window = nullptr;
-SDL_Renderer* renderer = nullptr;
-shaderType currentshaderType = shaderType::Sun;
 
 bool init() {
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
@@ -38,8 +54,8 @@ bool init() {
         return false;
     }
 
+    // the renderer is made by the present queue, on the thread that presents
     window = SDL_CreateWindow("Out Of Space Shaders by bl33h", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
 
     setupNoise();
 
@@ -50,82 +66,106 @@ void setColor(const Color& color) {
     currentColor = color;
 }
 
-std::vector<Vertex> vertexShaderStep(const std::vector<glm::vec3>& VBO, const Uniforms& uniforms) {
-    std::vector<Vertex> transformedVertices(VBO.size() / 3);
-    for (size_t i = 0; i < VBO.size() / 3; ++i) {
-        Vertex vertex = { VBO[i * 3], VBO[i * 3 + 1], VBO[i * 3 + 2] };;
-        transformedVertices[i] = vertexShader(vertex, uniforms);
-    }
-    return transformedVertices;
-}
-
-std::vector<std::vector<Vertex>> primitiveAssemblyStep(const std::vector<Vertex>& transformedVertices) {
-    std::vector<std::vector<Vertex>> assembledVertices(transformedVertices.size() / 3);
-    for (size_t i = 0; i < transformedVertices.size() / 3; ++i) {
-        Vertex edge1 = transformedVertices[3 * i];
-        Vertex edge2 = transformedVertices[3 * i + 1];
-        Vertex edge3 = transformedVertices[3 * i + 2];
-        assembledVertices[i] = { edge1, edge2, edge3 };
-    }
-    return assembledVertices;
-}
-
-std::vector<Fragment> rasterizationStep(const std::vector<std::vector<Vertex>>& assembledVertices) {
-    std::vector<Fragment> concurrentFragments;
-    for (size_t i = 0; i < assembledVertices.size(); ++i) {
-        std::vector<Fragment> rasterizedTriangle = triangle(
-            assembledVertices[i][0],
-            assembledVertices[i][1],
-            assembledVertices[i][2]
-        );
-        std::lock_guard<std::mutex> lock(std::mutex);
-        for (const auto& fragment : rasterizedTriangle) {
-            concurrentFragments.push_back(fragment);
-        }
-    }
-    return concurrentFragments;
-}
-
-void fragmentShaderStep( std::vector<Fragment>& concurrentFragments, shaderType shaderType) {
-for (size_t i = 0; i < concurrentFragments.size(); ++i) {
-        const Fragment& fragment = fragmentShader(concurrentFragments[i], shaderType);
-        point(fragment);
-    }
-}
-
-void render(const std::vector<glm::vec3>& VBO, const Uniforms& uniforms) {
-    std::vector<Vertex> transformedVertices = vertexShaderStep(VBO, uniforms);
-    std::vector<std::vector<Vertex>> assembledVertices = primitiveAssemblyStep(transformedVertices);
-    std::vector<Fragment> concurrentFragments = rasterizationStep(assembledVertices);
-    fragmentShaderStep(concurrentFragments, currentshaderType);
-    if (moonPresent) {
-            fragmentShaderStep(concurrentFragments, currentshaderType);
-    }
-}
-
-void toggleFragmentShader() {
-    switch (currentshaderType) {
+void toggleFragmentShader(shaderType& shader) {
+    switch (shader) {
         case shaderType::Earth:
-            currentshaderType = shaderType::Neptune;
+            shader = shaderType::Neptune;
             break;
         case shaderType::Neptune:
-            currentshaderType = shaderType::Venus;
+            shader = shaderType::Venus;
             break;
         case shaderType::Venus:
-            currentshaderType = shaderType::Random;
+            shader = shaderType::Random;
             break;
         case shaderType::Random:
-            currentshaderType = shaderType::Pluton;
+            shader = shaderType::Pluton;
             break;
         case shaderType::Pluton:
-            currentshaderType = shaderType::Sun;
+            shader = shaderType::Sun;
             break;
         case shaderType::Sun:
-            currentshaderType = shaderType::Earth;
+            shader = shaderType::Earth;
+            break;
+        default:
+            shader = shaderType::Earth;
             break;
     }
 }
 
+// the planet in the middle, with the moon and the sun circling it while it shows Earth
+struct SolarSystem {
+    uint32_t planet;
+    uint32_t moon;
+    uint32_t sun;
+};
+
+SolarSystem buildSolarSystem(Scene& scene, const MeshView& sphere) {
+    uint32_t mesh = scene.addMesh(sphere);
+    SolarSystem system;
+
+    BodyDescription planet;
+    planet.mesh = mesh;
+    planet.shader = shaderType::Sun;
+    system.planet = scene.addBody(planet);
+
+    BodyDescription moon;
+    moon.mesh = mesh;
+    moon.shader = shaderType::Moon;
+    moon.scale = 0.4f;
+    moon.orbit.semiMajorAxis = 0.85f;
+    moon.orbit.meanMotion = 1.5f;
+    moon.orbit.parent = system.planet;
+    moon.visible = false;
+    system.moon = scene.addBody(moon);
+
+    BodyDescription sun = moon;
+    sun.shader = shaderType::Sun;
+    sun.orbit.meanMotion = 0.5f;
+    system.sun = scene.addBody(sun);
+    return system;
+}
+
+void showCompanions(Scene& scene, const SolarSystem& system) {
+    bool earth = scene.shader[system.planet] == shaderType::Earth;
+    scene.visible[system.moon] = earth;
+    scene.visible[system.sun] = earth;
+}
+
+// every visible body, for drawing without culling
+void allVisibleBodies(const Scene& scene, std::vector<uint32_t>& bodies) {
+    bodies.clear();
+    for (size_t i = 0; i < scene.size(); ++i) {
+        if (scene.visible[i]) {
+            bodies.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+// draws the instances in the given order, one instanced draw per run of them
+// sharing a mesh; every body is a sphere, so the analytic path can stand in for
+// any of them. with an atlas, bodies small on screen are drawn from their sprites first
+void drawScene(RenderContext& context, const Scene& scene, Span<Instance> instances, const Uniforms& frame, std::vector<Instance>& remaining, bool analyticSpheres, ImpostorAtlas* atlas) {
+    for (size_t first = 0; first < instances.size();) {
+        uint32_t mesh = scene.mesh[instances[first].id];
+        size_t last = first;
+        while (last < instances.size() && scene.mesh[instances[last].id] == mesh) {
+            ++last;
+        }
+        Span<Instance> run = instances.subspan(first, last - first);
+        first = last;
+        if (atlas) {
+            remaining.clear();
+            drawImpostors(context, *atlas, scene.meshes[mesh], run, frame, remaining);
+            run = remaining;
+        }
+        if (analyticSpheres) {
+            drawSpheres(context, scene.meshes[mesh], run, frame);
+        } else {
+            drawInstanced(context, scene.meshes[mesh], run, frame);
+        }
+    }
+}
+
 glm::mat4 createViewportMatrix(size_t screenWidth, size_t screenHeight) {
     glm::mat4 viewport = glm::mat4(1.0f);
 
@@ -136,56 +176,372 @@ glm::mat4 createViewportMatrix(size_t screenWidth, size_t screenHeight) {
     return viewport;
 }
 
-int main(int argc, char* argv[]) {
-    if (!init()) {
-        return 1;
+// what V cycles through: the main camera alone, with a top-down overview in the
+// corner, or split into a stereo pair side by side
+enum class ViewMode { Single, Overview, Stereo };
+
+constexpr size_t OVERVIEW_WIDTH = 200;
+constexpr size_t OVERVIEW_HEIGHT = 150;
+constexpr float EYE_SEPARATION = 0.06f;
+
+// the cameras of one frame and the sprite atlas each of them uses; views looking
+// about the same way share an atlas, so a sprite is shaded once for all of them
+struct ViewSetup {
+    std::vector<RenderView> views;
+    std::vector<ImpostorAtlas*> atlases;  // by view
+};
+
+// kept between frames so drawing several views doesn't allocate
+struct MultiViewScratch {
+    std::vector<Instance> viewInstances;
+    std::vector<Instance> remaining;
+    std::vector<uint8_t> masks;
+};
+
+// the instances views[v] sees, by the bodies' view masks
+void instancesInView(Span<Instance> instances, const std::vector<uint8_t>& viewMasks, size_t v, std::vector<Instance>& viewInstances) {
+    viewInstances.clear();
+    for (const Instance& instance : instances) {
+        if (viewMasks[instance.id] & (1u << v)) {
+            viewInstances.push_back(instance);
+        }
     }
+}
 
-    std::vector<glm::vec3> vertices;
-    std::vector<glm::vec3> normals;
-        std::vector<glm::vec3> texCoords;
-    std::vector<Face> faces;
-    std::vector<glm::vec3> vertexBufferObject;
+// drawScene for several views at once; bit v of viewMasks[body] says whether
+// views[v] sees it. sprites and ray cast spheres are drawn view by view, the
+// meshes left over in one multi-view draw that transforms each of them once
+void drawSceneViews(RenderContext& context, const Scene& scene, Span<Instance> instances, std::vector<uint8_t>& viewMasks, const ViewSetup& setup, MultiViewScratch& scratch, bool analyticSpheres, bool impostors) {
+    for (size_t first = 0; first < instances.size();) {
+        uint32_t mesh = scene.mesh[instances[first].id];
+        size_t last = first;
+        while (last < instances.size() && scene.mesh[instances[last].id] == mesh) {
+            ++last;
+        }
+        Span<Instance> run = instances.subspan(first, last - first);
+        first = last;
+        for (size_t v = 0; v < setup.views.size() && (impostors || analyticSpheres); ++v) {
+            uint8_t bit = static_cast<uint8_t>(1u << v);
+            instancesInView(run, viewMasks, v, scratch.viewInstances);
+            context.target = setup.views[v].target;
+            if (impostors) {
+                // what was drawn as a sprite is done in this view
+                for (const Instance& instance : scratch.viewInstances) {
+                    viewMasks[instance.id] &= static_cast<uint8_t>(~bit);
+                }
+                scratch.remaining.clear();
+                drawImpostors(context, *setup.atlases[v], scene.meshes[mesh], scratch.viewInstances, setup.views[v].frame, scratch.remaining);
+                for (const Instance& instance : scratch.remaining) {
+                    viewMasks[instance.id] |= bit;
+                }
+                scratch.viewInstances.swap(scratch.remaining);
+            }
+            if (analyticSpheres) {
+                drawSpheres(context, scene.meshes[mesh], scratch.viewInstances, setup.views[v].frame);
+            }
+        }
+        context.target = nullptr;
+        if (!analyticSpheres) {
+            scratch.masks.clear();
+            for (const Instance& instance : run) {
+                scratch.masks.push_back(viewMasks[instance.id]);
+            }
+            drawInstancedViews(context, scene.meshes[mesh], run, scratch.masks, setup.views);
+        }
+    }
+}
 
-    std::string filePath = "src/objects/sphere.obj";
+// the views of a mode around the main camera; stereo eyes look parallel, apart
+// along the camera's right
+void setupViews(ViewMode mode, const Camera& camera, const Uniforms& main, RenderTarget eyes[2], RenderTarget& overview, std::vector<RenderView>& views) {
+    views.clear();
+    if (mode == ViewMode::Stereo) {
+        glm::vec3 forward = glm::normalize(camera.targetPosition - camera.cameraPosition);
+        glm::vec3 right = glm::normalize(glm::cross(forward, camera.upVector));
+        for (int eye = 0; eye < 2; ++eye) {
+            glm::vec3 offset = right * (eye == 0 ? -0.5f : 0.5f) * EYE_SEPARATION;
+            RenderView view;
+            view.frame = main;
+            view.frame.view = glm::lookAt(camera.cameraPosition + offset, camera.targetPosition + offset, camera.upVector);
+            view.frame.projection = glm::perspective(glm::radians(45.0f), static_cast<float>(eyes[eye].width) / eyes[eye].height, 0.1f, 100.0f);
+            view.frame.viewport = createViewportMatrix(eyes[eye].width, eyes[eye].height);
+            view.target = &eyes[eye];
+            views.push_back(view);
+        }
+        return;
+    }
 
-    if (!triangleFill(filePath, vertices, normals, texCoords,  faces)) {
-            std::cout << "Error: Could not load OBJ file." << std::endl;
-        SDL_DestroyRenderer(renderer);
-        SDL_DestroyWindow(window);
-        SDL_Quit();
-        return 1;
+    views.push_back(RenderView{main, nullptr});
+    if (mode == ViewMode::Overview) {
+        RenderView view;
+        view.frame = main;
+        view.frame.view = glm::lookAt(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+        view.frame.projection = glm::perspective(glm::radians(45.0f), static_cast<float>(overview.width) / overview.height, 0.1f, 100.0f);
+        view.frame.viewport = createViewportMatrix(overview.width, overview.height);
+        view.target = &overview;
+        views.push_back(view);
     }
+}
 
-    for (const auto& face : faces)
-    {
-        for (int i = 0; i < 3; ++i)
-        {
-            glm::vec3 vertexPosition = vertices[face.vertexIndices[i]];
+// the atlas each view uses: stereo eyes share the main one, the overview has its own
+void setupViewAtlases(ViewMode mode, ImpostorAtlas* mainAtlas, ImpostorAtlas* overviewAtlas, ViewSetup& setup) {
+    setup.atlases.assign(setup.views.size(), mainAtlas);
+    if (mode == ViewMode::Overview) {
+        setup.atlases[1] = overviewAtlas;
+    }
+}
+
+// what input asks of the frames still to be prepared; the drawing thread
+// fills it in and the next frame prepared takes it
+struct FrameRequests {
+    std::mutex mutex;
+    ViewMode viewMode = ViewMode::Single;
+    bool cullWholeBodies = true;
+    bool frontToBack = true;
+    int shaderToggles = 0;
+    std::vector<glm::ivec2> picks;
+};
+
+// everything drawing a frame needs of the scene, taken while preparing it, so
+// the frames after it can move the scene on while it is drawn
+struct PreparedFrame {
+    ViewMode viewMode = ViewMode::Single;
+    bool frontToBack = true;
+    ViewSetup setup;                  // the cameras other than the main one's frame
+    std::vector<Instance> instances;  // the bodies to draw, in draw order
+    std::vector<uint8_t> viewMasks;   // by body, the views that see it; zero again once drawn
+    size_t outside = 0;
+    size_t occluded = 0;
+    size_t steps = 0;
+    size_t droppedSteps = 0;
+};
+
+size_t residentMemoryBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    if (!(statm >> pages >> resident)) {
+        return 0;
+    }
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
 
-            glm::vec3 vertexNormal = normals[face.normalIndices[i]];
+// averages over the frames since the last report
+void reportFrameStats(const Scene& scene, const RenderStats& stats, size_t frames, double milliseconds, size_t steps, size_t droppedSteps, uint64_t presentedFrames, uint64_t droppedFrames, bool frontToBack) {
+    std::cout << "Scene: " << scene.size() << " bodies, "
+        << milliseconds / frames << " ms per frame, "
+        << (frontToBack ? "front to back, " : "unsorted, ")
+        << presentedFrames << " presented, "
+        << droppedFrames << " frames dropped, "
+        << static_cast<double>(steps) / frames << " steps per frame, "
+        << droppedSteps << " steps dropped, "
+        << stats.drawnInstances / frames << " drawn, "
+        << stats.culledInstances / frames << " culled, "
+        << stats.outsideBodies / frames << " outside, "
+        << stats.occludedBodies / frames << " occluded, "
+        << stats.impostors / frames << " impostors, "
+        << stats.impostorRefreshes / frames << " refreshed, "
+        << stats.projectedVertices / frames << " vertices shared between views, "
+        << stats.triangles / frames << " triangles, "
+        << stats.fragments / frames << " fragments, "
+        << stats.shadedFragments / frames << " shaded, "
+        << (stats.coveredPixels > 0 ? static_cast<double>(stats.shadedFragments) / stats.coveredPixels : 0.0) << " overdraw, "
+        << scene.memoryBytes() / (1024 * 1024) << " MB scene, "
+        << residentMemoryBytes() / (1024 * 1024) << " MB resident" << std::endl;
+}
 
-            glm::vec3 vertexTexture = texCoords[face.texIndices[i]];
+// the body under the mouse and the one nearest to it, looked up in the tree
+void pickBody(const Scene& scene, const BodyBvh& bvh, const Uniforms& frame, int mouseX, int mouseY) {
+    // the framebuffer's rows go bottom up, the mouse's top down
+    glm::vec2 ndc = glm::vec2(
+        2.0f * (mouseX + 0.5f) / SCREEN_WIDTH - 1.0f,
+        1.0f - 2.0f * (mouseY + 0.5f) / SCREEN_HEIGHT
+    );
+    glm::mat4 worldFromClip = glm::inverse(frame.projection * frame.view);
+    glm::vec4 nearPoint = worldFromClip * glm::vec4(ndc.x, ndc.y, -1.0f, 1.0f);
+    glm::vec4 farPoint = worldFromClip * glm::vec4(ndc.x, ndc.y, 1.0f, 1.0f);
+    glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+
+    BodyHit hit;
+    if (!raycastBodies(bvh, scene, origin, direction, hit)) {
+        std::cout << "Picked nothing" << std::endl;
+        return;
+    }
+    std::cout << "Picked body " << hit.body << " at " << hit.distance;
+    BodyHit nearest;
+    glm::vec3 center = glm::vec3(bvh.spheres[bvh.slots[hit.body]]);
+    if (nearestBody(bvh, scene, center, hit.body, nearest)) {
+        std::cout << ", nearest body " << nearest.body << " at " << nearest.distance;
+    }
+    std::cout << std::endl;
+}
 
-            vertexBufferObject.push_back(vertexPosition);
-            vertexBufferObject.push_back(vertexNormal);
-            vertexBufferObject.push_back(vertexTexture);
+struct Options {
+    std::string meshPath;  // empty = generated sphere
+    SphereKind sphereKind = SphereKind::UV;
+    int sphereSubdivisions = 2;
+    size_t beltBodies = 0;  // stress scene: asteroids around the sun, 0 = off
+    bool nbody = false;     // the belt moved by gravity instead of fixed orbits
+    bool benchNBody = false;
+    NBodySettings nbodySettings;
+    double stepsPerSecond = 60.0;
+    size_t fixedSteps = 0;  // steps per frame for offline runs, 0 = follow real time
+    JobSystemSettings jobs;
+    bool benchJobs = false;
+    size_t pipelineDepth = 1;  // frames prepared ahead of the one drawn, 0 = one after the other
+    size_t presentBuffers = 3;
+    // present on the drawing thread instead of a thread of its own; macOS only
+    // lets the main thread render
+#if defined(__APPLE__)
+    bool syncPresent = true;
+#else
+    bool syncPresent = false;
+#endif
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument == "--mesh" && hasValue) {
+            options.meshPath = argv[++i];
+        } else if (argument == "--sphere" && hasValue) {
+            if (!parseSphereKind(argv[++i], options.sphereKind)) {
+                std::cout << "Error: --sphere expects uv, ico or cube." << std::endl;
+                return false;
+            }
+        } else if (argument == "--subdivisions" && hasValue) {
+            options.sphereSubdivisions = std::atoi(argv[++i]);
+        } else if (argument == "--belt" && hasValue) {
+            long long bodies = std::atoll(argv[++i]);
+            if (bodies <= 0) {
+                std::cout << "Error: --belt expects a positive body count." << std::endl;
+                return false;
+            }
+            options.beltBodies = static_cast<size_t>(bodies);
+        } else if (argument == "--nbody") {
+            options.nbody = true;
+        } else if (argument == "--bench-nbody") {
+            options.benchNBody = true;
+        } else if (argument == "--opening-angle" && hasValue) {
+            options.nbodySettings.openingAngle = static_cast<float>(std::atof(argv[++i]));
+        } else if (argument == "--step-rate" && hasValue) {
+            options.stepsPerSecond = std::atof(argv[++i]);
+            if (options.stepsPerSecond <= 0.0) {
+                std::cout << "Error: --step-rate expects positive steps per second." << std::endl;
+                return false;
+            }
+        } else if (argument == "--fixed-steps" && hasValue) {
+            long long steps = std::atoll(argv[++i]);
+            if (steps <= 0) {
+                std::cout << "Error: --fixed-steps expects a positive step count." << std::endl;
+                return false;
+            }
+            options.fixedSteps = static_cast<size_t>(steps);
+        } else if (argument == "--threads" && hasValue) {
+            int threads = std::atoi(argv[++i]);
+            if (threads <= 0) {
+                std::cout << "Error: --threads expects a positive thread count." << std::endl;
+                return false;
+            }
+            options.jobs.threadCount = static_cast<unsigned int>(threads);
+        } else if (argument == "--pin-threads") {
+            options.jobs.pinThreads = true;
+        } else if (argument == "--bench-jobs") {
+            options.benchJobs = true;
+        } else if (argument == "--pipeline-depth" && hasValue) {
+            int depth = std::atoi(argv[++i]);
+            if (depth < 0 || depth > 2) {
+                std::cout << "Error: --pipeline-depth expects 0, 1 or 2 frames." << std::endl;
+                return false;
+            }
+            options.pipelineDepth = static_cast<size_t>(depth);
+        } else if (argument == "--present-buffers" && hasValue) {
+            int buffers = std::atoi(argv[++i]);
+            if (buffers < 2 || buffers > 3) {
+                std::cout << "Error: --present-buffers expects 2 or 3 buffers." << std::endl;
+                return false;
+            }
+            options.presentBuffers = static_cast<size_t>(buffers);
+        } else if (argument == "--sync-present") {
+            options.syncPresent = true;
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--mesh file.obj] [--sphere uv|ico|cube] [--subdivisions n] [--belt bodies] [--nbody] [--opening-angle theta] [--bench-nbody] [--step-rate hz] [--fixed-steps n] [--threads n] [--pin-threads] [--bench-jobs] [--pipeline-depth 0|1|2] [--present-buffers 2|3] [--sync-present]" << std::endl;
+            return false;
         }
     }
+    return true;
+}
 
-    Uniforms uniforms;
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
 
-    glm::mat4 model = glm::mat4(1);
-    glm::mat4 view = glm::mat4(1);
-    glm::mat4 projection = glm::mat4(1);
+    configureJobSystem(options.jobs);
+    if (options.benchJobs) {
+        benchmarkJobs(options.jobs);
+        return 0;
+    }
+    if (options.benchNBody) {
+        benchmarkNBody({10000, 100000, 1000000}, options.nbodySettings);
+        return 0;
+    }
+    if (options.nbody && options.beltBodies == 0) {
+        std::cout << "Error: --nbody needs a belt to simulate, see --belt." << std::endl;
+        return 1;
+    }
+
+    if (!init()) {
+        return 1;
+    }
+
+    MappedMesh sphereMesh;
+    MeshView sphere;
+
+    if (options.meshPath.empty()) {
+        sphere = generatedSphere(options.sphereKind, options.sphereSubdivisions).view();
+    } else if (loadMeshCache(options.meshPath, sphereMesh)) {
+        sphere = sphereMesh.mesh;
+    } else {
+            std::cout << "Error: Could not load OBJ file." << std::endl;
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
 
-    glm::vec3 translationVector(0.0f, 0.0f, 0.0f);
-    float a = 45.0f;
-    glm::vec3 rotationAxis(0.0f, 1.0f, 0.0f); // Rotate around the Y-axis
-    glm::vec3 scaleFactor(1.0f, 1.0f, 1.0f);
+    Uniforms uniforms;
 
-    glm::mat4 translation = glm::translate(glm::mat4(1.0f), translationVector);
-    glm::mat4 scale = glm::scale(glm::mat4(1.0f), scaleFactor);
+    Scene scene;
+    SolarSystem solarSystem = buildSolarSystem(scene, sphere);
+    size_t firstRock = scene.size();
+    if (options.beltBodies > 0) {
+        uint32_t rock = scene.addMesh(generatedSphere(SphereKind::Ico, 1).view());
+        addAsteroidBelt(scene, rock, options.beltBodies);
+    }
+    SimulationClock clock;
+    clock.time = 45.0;
+    clock.stepsPerSecond = options.stepsPerSecond;
+    clock.fixedSteps = options.fixedSteps;
+
+    // the planet and the belt; the moon and the sun keep their orbits. the planet
+    // weighs what the belt's speeds imply, the rocks the same per volume
+    NBodySystem nbody;
+    if (options.nbody) {
+        BeltSettings belt;
+        float planetMass = glm::radians(1.0f) * glm::radians(1.0f) * belt.innerRadius * belt.innerRadius * belt.innerRadius;
+        std::vector<uint32_t> bodies = {solarSystem.planet};
+        std::vector<float> masses = {planetMass};
+        for (size_t i = firstRock; i < scene.size(); ++i) {
+            float s = scene.scale[i];
+            bodies.push_back(static_cast<uint32_t>(i));
+            masses.push_back(planetMass * s * s * s);
+        }
+        nbody.settings = options.nbodySettings;
+        nbodyFromScene(nbody, scene, clock.time, bodies, masses);
+    }
 
     Camera camera;
     camera.cameraPosition = glm::vec3(0.0f, 0.0f, 2.5f);
@@ -199,7 +555,148 @@ int main(int argc, char* argv[]) {
     uniforms.projection = glm::perspective(fovRadians, aspectRatio, nearClip, farClip);
 
     uniforms.viewport = createViewportMatrix(SCREEN_WIDTH, SCREEN_HEIGHT);
-    int speed = 10;
+
+    RenderContext renderContext;
+    bool analyticSpheres = false;
+    bool impostors = true;
+    BodyCullScratch bodyCullScratch;
+    BodyBvh bodyBvh;
+    DrawOrderScratch drawOrderScratch;
+    std::vector<uint32_t> drawnBodies;
+    ImpostorAtlas impostorAtlas;
+    std::unique_ptr<ImpostorAtlas> overviewAtlas;  // 16 MB, made when first needed
+    MultiViewScratch multiViewScratch;
+    RenderTarget eyeTargets[2] = {RenderTarget(SCREEN_WIDTH / 2, SCREEN_HEIGHT), RenderTarget(SCREEN_WIDTH / 2, SCREEN_HEIGHT)};
+    RenderTarget overviewTarget(OVERVIEW_WIDTH, OVERVIEW_HEIGHT);
+    std::vector<uint32_t> viewBodies;
+    std::vector<glm::ivec2> picks;
+    std::vector<Instance> remaining;
+    std::chrono::steady_clock::duration updateTime{0};
+    size_t updatedBodies = 0;
+    auto lastFrame = std::chrono::steady_clock::now();
+
+    // the scene, the clock, the tree and uniforms belong to whoever prepares
+    // frames; drawing only reads the frame it was handed and the meshes
+    FrameRequests requests;
+    std::vector<PreparedFrame> frames(options.pipelineDepth + 1);
+    auto prepareFrame = [&](size_t slot) {
+        PreparedFrame& frame = frames[slot];
+        int shaderToggles = 0;
+        bool cullWholeBodies = true;
+        {
+            std::lock_guard<std::mutex> lock(requests.mutex);
+            frame.viewMode = requests.viewMode;
+            cullWholeBodies = requests.cullWholeBodies;
+            frame.frontToBack = requests.frontToBack;
+            shaderToggles = requests.shaderToggles;
+            requests.shaderToggles = 0;
+            picks.swap(requests.picks);
+        }
+        for (; shaderToggles > 0; --shaderToggles) {
+            toggleFragmentShader(scene.shader[solarSystem.planet]);
+            showCompanions(scene, solarSystem);
+        }
+        // against the tree of the last frame prepared, which is at most a few frames past the one clicked on
+        for (const glm::ivec2& pick : picks) {
+            pickBody(scene, bodyBvh, uniforms, pick.x, pick.y);
+        }
+        picks.clear();
+
+        auto frameStart = std::chrono::steady_clock::now();
+        uint64_t droppedBefore = clock.droppedSteps;
+        size_t steps = advanceClock(clock, std::chrono::duration<double>(frameStart - lastFrame).count());
+        lastFrame = frameStart;
+        double time = renderTime(clock);
+        frame.steps = steps;
+        frame.droppedSteps = static_cast<size_t>(clock.droppedSteps - droppedBefore);
+
+        // everything per body except the draw itself is timed, to keep it cheap as scenes grow.
+        // the belt is stepped, the orbits are solved straight at the time drawn
+        auto updateStart = std::chrono::steady_clock::now();
+        if (options.nbody) {
+            for (size_t step = 0; step < steps; ++step) {
+                stepNBody(nbody, static_cast<float>(clock.step));
+            }
+            solveOrbits(scene.orbits, time);
+            writeNBodyToScene(nbody, scene, static_cast<float>(interpolationAlpha(clock)));
+            placeBodies(scene, time);
+        } else {
+            updateScene(scene, time);
+        }
+        updateBodyBvh(bodyBvh, scene);
+        updateTime += std::chrono::steady_clock::now() - updateStart;
+        updatedBodies += scene.size();
+
+        uniforms.view = glm::lookAt(
+            camera.cameraPosition,
+            camera.targetPosition,
+            camera.upVector
+        );
+        setupViews(frame.viewMode, camera, uniforms, eyeTargets, overviewTarget, frame.setup.views);
+
+        frame.outside = 0;
+        frame.occluded = 0;
+        if (frame.viewMode == ViewMode::Single) {
+            if (cullWholeBodies) {
+                BodyCullStats culled = cullBodies(scene, bodyBvh, uniforms, drawnBodies, bodyCullScratch);
+                frame.outside += culled.outside;
+                frame.occluded += culled.occluded;
+            } else {
+                allVisibleBodies(scene, drawnBodies);
+            }
+            if (frame.frontToBack) {
+                sortFrontToBack(scene, uniforms, drawnBodies, drawOrderScratch);
+            }
+        } else {
+            // every body any view sees, once, with the views that see it
+            frame.viewMasks.resize(scene.size(), 0);
+            drawnBodies.clear();
+            for (size_t v = 0; v < frame.setup.views.size(); ++v) {
+                if (cullWholeBodies) {
+                    BodyCullStats culled = cullBodies(scene, bodyBvh, frame.setup.views[v].frame, viewBodies, bodyCullScratch);
+                    frame.outside += culled.outside;
+                    frame.occluded += culled.occluded;
+                } else {
+                    allVisibleBodies(scene, viewBodies);
+                }
+                for (uint32_t body : viewBodies) {
+                    if (frame.viewMasks[body] == 0) {
+                        drawnBodies.push_back(body);
+                    }
+                    frame.viewMasks[body] |= static_cast<uint8_t>(1u << v);
+                }
+            }
+            // the first view's order, the others are nearly the same or small
+            if (frame.frontToBack) {
+                sortFrontToBack(scene, frame.setup.views[0].frame, drawnBodies, drawOrderScratch);
+            }
+        }
+        // culling hands the bodies over in the tree's order, which is no order to compare against
+        if (!frame.frontToBack) {
+            std::sort(drawnBodies.begin(), drawnBodies.end());
+        }
+
+        frame.instances.clear();
+        for (uint32_t body : drawnBodies) {
+            frame.instances.push_back(Instance{scene.model[body], scene.shader[body], body});
+        }
+    };
+    PresentQueue presentQueue;
+    if (!startPresentQueue(presentQueue, window, options.presentBuffers, !options.syncPresent)) {
+        std::cout << "Error: SDL_CreateRenderer failed." << std::endl;
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
+    PresentFence lastPresent;
+    FramePipeline pipeline;
+    startFramePipeline(pipeline, options.pipelineDepth, prepareFrame);
+
+    auto reportStart = std::chrono::steady_clock::now();
+    size_t reportFrames = 0;
+    uint64_t reportSteps = 0;
+    uint64_t reportDropped = 0;
+    PresentStats reportPresents;
 
     bool running = true;
     while (running) {
@@ -209,94 +706,115 @@ int main(int argc, char* argv[]) {
         if (event.type == SDL_QUIT) {
             running = false;
         }
+        if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT) {
+            std::lock_guard<std::mutex> lock(requests.mutex);
+            requests.picks.push_back(glm::ivec2(event.button.x, event.button.y));
+        }
         if (event.type == SDL_KEYDOWN) {
+            std::lock_guard<std::mutex> lock(requests.mutex);
             switch (event.key.keysym.sym) {
                 case SDLK_SPACE:
-                    toggleFragmentShader();
+                    ++requests.shaderToggles;
+                    break;
+                case SDLK_r:
+                    analyticSpheres = !analyticSpheres;
+                    std::cout << (analyticSpheres ? "Ray casting spheres" : "Rasterizing sphere meshes") << std::endl;
                     break;
+                case SDLK_c:
+                    requests.cullWholeBodies = !requests.cullWholeBodies;
+                    std::cout << (requests.cullWholeBodies ? "Body culling on" : "Body culling off") << std::endl;
+                    break;
+                case SDLK_o:
+                    requests.frontToBack = !requests.frontToBack;
+                    std::cout << (requests.frontToBack ? "Drawing front to back" : "Drawing in scene order") << std::endl;
+                    break;
+                case SDLK_i:
+                    impostors = !impostors;
+                    std::cout << (impostors ? "Impostors on" : "Impostors off") << std::endl;
+                    break;
+                case SDLK_v: {
+                    ViewMode& viewMode = requests.viewMode;
+                    viewMode = viewMode == ViewMode::Single ? ViewMode::Overview : viewMode == ViewMode::Overview ? ViewMode::Stereo : ViewMode::Single;
+                    std::cout << (viewMode == ViewMode::Single ? "One view" : viewMode == ViewMode::Overview ? "Main view with an overview" : "Stereo views") << std::endl;
+                    break;
+                }
                 }
             }
         }
 
-        a += 1.0;
-        glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), glm::radians(a), rotationAxis);
-
-        uniforms.model = translation * rotation * scale;
-
-        uniforms.view = glm::lookAt(
-            camera.cameraPosition,
-            camera.targetPosition,
-            camera.upVector
-        );
+        // with a pipeline the next frames are prepared while this one is drawn
+        PreparedFrame& frame = frames[acquireFrame(pipeline)];
+        renderContext.stats.outsideBodies += frame.outside;
+        renderContext.stats.occludedBodies += frame.occluded;
+        reportSteps += frame.steps;
+        reportDropped += frame.droppedSteps;
 
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-        SDL_RenderClear(renderer);
         clearFramebuffer();
 
-        render(vertexBufferObject, uniforms);
-
-    if (currentshaderType == shaderType::Earth) {
-        moonPresent = true;
-        
-        float x_translation = 3.0f;
-        float y_translation = 0.0f;
-        float z_translation = 0.0f;
-        float moonOrbitRadius = 0.85f;
-        float earthRotationAngle = glm::radians(a);
-
-        float moonRotationAngle = glm::radians(a * 1.5f);
-        float moonXPosition = moonOrbitRadius * glm::cos(moonRotationAngle);
-        float moonZPosition = moonOrbitRadius * glm::sin(moonRotationAngle);
-
-        glm::mat4 moonModel = glm::mat4(1.0f);
-        moonModel = glm::translate(moonModel, glm::vec3(moonXPosition, 0.0f, moonZPosition));
-
-        glm::vec3 earthRotationAxis(0.0f, 1.0f, 0.0f);
-        moonModel = glm::rotate(moonModel, earthRotationAngle, earthRotationAxis);
-        float moonScaleFactor = 0.4f;
-        moonModel = glm::scale(moonModel, glm::vec3(moonScaleFactor, moonScaleFactor, moonScaleFactor));
-
-        Uniforms moonUniforms = uniforms;
-        moonUniforms.model = moonModel;
+        if (impostors) {
+            beginImpostorFrame(impostorAtlas);
+        }
+        if (frame.viewMode == ViewMode::Single) {
+            drawScene(renderContext, scene, frame.instances, frame.setup.views[0].frame, remaining, analyticSpheres, impostors ? &impostorAtlas : nullptr);
+        } else {
+            if (frame.viewMode == ViewMode::Overview && !overviewAtlas) {
+                overviewAtlas.reset(new ImpostorAtlas());
+            }
+            setupViewAtlases(frame.viewMode, &impostorAtlas, overviewAtlas.get(), frame.setup);
+            if (impostors && frame.viewMode == ViewMode::Overview) {
+                beginImpostorFrame(*overviewAtlas);
+            }
+            for (const RenderView& view : frame.setup.views) {
+                if (view.target) {
+                    view.target->clear();
+                }
+            }
+            drawSceneViews(renderContext, scene, frame.instances, frame.viewMasks, frame.setup, multiViewScratch, analyticSpheres, impostors);
+            for (const Instance& instance : frame.instances) {
+                frame.viewMasks[instance.id] = 0;
+            }
 
-        shaderType originalEarthshaderType = currentshaderType;
-        currentshaderType = shaderType::Moon;
-        render(vertexBufferObject, moonUniforms);
-        currentshaderType = originalEarthshaderType;
+            if (frame.viewMode == ViewMode::Stereo) {
+                copyToFramebuffer(eyeTargets[0], 0, 0);
+                copyToFramebuffer(eyeTargets[1], SCREEN_WIDTH / 2, 0);
+            } else {
+                copyToFramebuffer(overviewTarget, SCREEN_WIDTH - OVERVIEW_WIDTH, SCREEN_HEIGHT - OVERVIEW_HEIGHT);
+            }
+        }
+        // the framebuffer holds all of it now, its slot can take the next frame
+        bool frontToBack = frame.frontToBack;
+        releaseFrame(pipeline);
+        renderContext.stats.coveredPixels += coveredPixels();
+        // presented while the next frame is drawn; offline runs keep every frame by
+        // waiting for the one before instead of letting this one push it out
+        PresentFence presented = presentFramebuffer(presentQueue);
+        if (options.fixedSteps > 0) {
+            waitForPresent(presentQueue, lastPresent);
+        }
+        lastPresent = presented;
+
+        ++reportFrames;
+        std::chrono::duration<double, std::milli> sinceReport = std::chrono::steady_clock::now() - reportStart;
+        if (sinceReport.count() >= 1000.0) {
+            PresentStats presents = presentStats(presentQueue);
+            reportFrameStats(scene, renderContext.stats, reportFrames, sinceReport.count(), reportSteps, reportDropped,
+                presents.presented - reportPresents.presented, presents.dropped - reportPresents.dropped, frontToBack);
+            reportPresents = presents;
+            renderContext.stats = RenderStats();
+            reportStart = std::chrono::steady_clock::now();
+            reportFrames = 0;
+            reportSteps = 0;
+            reportDropped = 0;
+        }
     }
+    stopFramePipeline(pipeline);
+    stopPresentQueue(presentQueue);
 
-    if (currentshaderType == shaderType::Earth) {
-        sunPresent = true;
-        float x_translation = 3.0f;
-        float y_translation = 0.0f;
-        float z_translation = 0.0f;
-        float sunOrbitRadius = 0.85f;
-        float earthRotationAngle = glm::radians(a);
-
-        float sunRotationAngle = glm::radians(a * 0.5f);
-
-        float sunXPosition = sunOrbitRadius * glm::cos(sunRotationAngle);
-        float sunZPosition = sunOrbitRadius * glm::sin(sunRotationAngle);
-
-        glm::mat4 sunModel = glm::mat4(1.0f);
-        sunModel = glm::translate(sunModel, glm::vec3(sunXPosition, 0.0f, sunZPosition));
-        glm::vec3 earthRotationAxis(0.0f, 1.0f, 0.0f);
-        sunModel = glm::rotate(sunModel, earthRotationAngle, earthRotationAxis);
-
-        float sunScaleFactor = 0.4f;
-        sunModel = glm::scale(sunModel, glm::vec3(sunScaleFactor, sunScaleFactor, sunScaleFactor));
-        Uniforms sunUniforms = uniforms;
-        sunUniforms.model = sunModel;
-
-        shaderType originalEarthshaderType = currentshaderType;
-        currentshaderType = shaderType::Sun;
-        render(vertexBufferObject, sunUniforms);
-        currentshaderType = originalEarthshaderType;
-    }
-        renderBuffer(renderer);
+    if (updatedBodies > 0) {
+        std::cout << "Scene update: " << std::chrono::duration<double, std::nano>(updateTime).count() / updatedBodies
+            << " ns per body" << std::endl;
     }
 
-    SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
 
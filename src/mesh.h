@@ -0,0 +1,132 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: mesh.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// read-only view over contiguous elements, used to hand mesh data to the
+// pipeline without copying it out of wherever it lives (vector or mapping)
+template <typename T>
+struct Span {
+    const T* data = nullptr;
+    size_t count = 0;
+
+    Span() = default;
+    Span(const T* data, size_t count) : data(data), count(count) {}
+    Span(const std::vector<T>& values) : data(values.data()), count(values.size()) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](size_t i) const { return data[i]; }
+    const T* begin() const { return data; }
+    const T* end() const { return data + count; }
+
+    Span subspan(size_t offset, size_t length) const { return Span(data + offset, length); }
+};
+
+// vertex attributes stored one array per attribute (structure of arrays), so
+// a stage streams only the attributes it actually reads
+struct VertexStreams {
+    Span<glm::vec3> positions;
+    Span<glm::vec3> normals;
+    Span<glm::vec2> texCoords;
+
+    size_t size() const { return positions.size(); }
+
+    VertexStreams prefix(size_t count) const {
+        return VertexStreams{positions.subspan(0, count), normals.subspan(0, count), texCoords.subspan(0, count)};
+    }
+};
+
+// one level of detail: a range of the shared index buffer drawing from the
+// first vertexCount vertices, coarser levels use a prefix of the finer ones
+struct MeshLod {
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    uint32_t vertexCount;
+    float error;  // object-space distance the level may deviate from level 0
+    uint32_t meshletOffset;
+    uint32_t meshletCount;
+};
+
+// small cluster of a level's triangles with the bounds used to reject it as
+// a whole; triangles index the cluster's own vertex list with 8-bit indices
+struct Meshlet {
+    uint32_t vertexOffset;    // into meshletVertices
+    uint32_t triangleOffset;  // into meshletTriangles, 3 entries per triangle
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+    glm::vec3 center;
+    float radius;
+    glm::vec3 coneApex;
+    float coneCutoff;         // backfacing when dot(normalize(apex - eye), axis) >= cutoff
+    glm::vec3 coneAxis;
+    float padding;
+};
+
+struct MeshView {
+    VertexStreams streams;
+    Span<uint32_t> indices;  // three per triangle, every level back to back
+    Span<MeshLod> lods;      // finest first; empty means indices is a single level
+    Span<Meshlet> meshlets;  // every level back to back, empty when not clustered
+    Span<uint32_t> meshletVertices;
+    Span<uint8_t> meshletTriangles;
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+
+    size_t lodCount() const { return lods.empty() ? 1 : lods.size(); }
+
+    MeshView lod(size_t level) const {
+        if (lods.empty()) {
+            return *this;
+        }
+        const MeshLod& selected = lods[level];
+        MeshView view;
+        view.streams = streams.prefix(selected.vertexCount);
+        view.indices = indices.subspan(selected.indexOffset, selected.indexCount);
+        if (!meshlets.empty()) {
+            view.meshlets = meshlets.subspan(selected.meshletOffset, selected.meshletCount);
+            view.meshletVertices = meshletVertices;
+            view.meshletTriangles = meshletTriangles;
+        }
+        view.boundsCenter = boundsCenter;
+        view.boundsRadius = boundsRadius;
+        return view;
+    }
+};
+
+// owning storage behind a MeshView
+struct MeshData {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texCoords;
+    std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint8_t> meshletTriangles;
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+
+    MeshView view() const {
+        MeshView view;
+        view.streams = VertexStreams{positions, normals, texCoords};
+        view.indices = indices;
+        view.lods = lods;
+        view.meshlets = meshlets;
+        view.meshletVertices = meshletVertices;
+        view.meshletTriangles = meshletTriangles;
+        view.boundsCenter = boundsCenter;
+        view.boundsRadius = boundsRadius;
+        return view;
+    }
+};
@@ -0,0 +1,283 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: meshCache.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "meshCache.h"
+#include "triangleFill.h"
+#include "meshLod.h"
+#include "meshlet.h"
+#include "meshOptimize.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char MESH_CACHE_MAGIC[8] = {'O', 'O', 'S', 'M', 'E', 'S', 'H', '\0'};
+
+static uint64_t alignUp(uint64_t value) {
+    return (value + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT;
+}
+
+// FNV-1a over 64-bit words; block sizes are padded to the alignment so the
+// length is always a multiple of 8
+static uint64_t checksum(const unsigned char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static bool sourceStamp(const std::string& path, uint64_t& size, int64_t& modified) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    size = static_cast<uint64_t>(info.st_size);
+    modified = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+}
+
+MappedMesh::~MappedMesh() {
+    release();
+}
+
+void MappedMesh::release() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappingSize);
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    owned = MeshData();
+    mesh = MeshView();
+}
+
+std::string meshCachePath(const std::string& objPath) {
+    return objPath + ".cache";
+}
+
+template <typename T>
+static void copyBlock(std::vector<unsigned char>& file, uint64_t offset, Span<T> block) {
+    if (!block.empty()) {
+        std::memcpy(file.data() + offset, block.data, block.size() * sizeof(T));
+    }
+}
+
+bool writeMeshCache(const std::string& cachePath, const MeshView& mesh, uint64_t sourceSize, int64_t sourceModified) {
+    const VertexStreams& streams = mesh.streams;
+    if (streams.normals.size() != streams.size() || streams.texCoords.size() != streams.size()) {
+        std::cout << "Failed to write the mesh cache, attribute streams differ in length: " << cachePath << std::endl;
+        return false;
+    }
+
+    MeshCacheHeader header{};
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    header.headerSize = sizeof(MeshCacheHeader);
+    header.sourceSize = sourceSize;
+    header.sourceModified = sourceModified;
+    header.vertexCount = streams.size();
+    header.positionOffset = alignUp(sizeof(MeshCacheHeader));
+    header.normalOffset = alignUp(header.positionOffset + header.vertexCount * sizeof(glm::vec3));
+    header.texCoordOffset = alignUp(header.normalOffset + header.vertexCount * sizeof(glm::vec3));
+    header.indexCount = mesh.indices.size();
+    header.indexOffset = alignUp(header.texCoordOffset + header.vertexCount * sizeof(glm::vec2));
+    header.lodCount = mesh.lods.size();
+    header.lodOffset = alignUp(header.indexOffset + header.indexCount * sizeof(uint32_t));
+    header.meshletCount = mesh.meshlets.size();
+    header.meshletOffset = alignUp(header.lodOffset + header.lodCount * sizeof(MeshLod));
+    header.meshletVertexCount = mesh.meshletVertices.size();
+    header.meshletVertexOffset = alignUp(header.meshletOffset + header.meshletCount * sizeof(Meshlet));
+    header.meshletTriangleCount = mesh.meshletTriangles.size();
+    header.meshletTriangleOffset = alignUp(header.meshletVertexOffset + header.meshletVertexCount * sizeof(uint32_t));
+    header.boundsCenter[0] = mesh.boundsCenter.x;
+    header.boundsCenter[1] = mesh.boundsCenter.y;
+    header.boundsCenter[2] = mesh.boundsCenter.z;
+    header.boundsRadius = mesh.boundsRadius;
+    header.fileSize = alignUp(header.meshletTriangleOffset + header.meshletTriangleCount * sizeof(uint8_t));
+
+    std::vector<unsigned char> file(header.fileSize, 0);
+    copyBlock(file, header.positionOffset, streams.positions);
+    copyBlock(file, header.normalOffset, streams.normals);
+    copyBlock(file, header.texCoordOffset, streams.texCoords);
+    copyBlock(file, header.indexOffset, mesh.indices);
+    copyBlock(file, header.lodOffset, mesh.lods);
+    copyBlock(file, header.meshletOffset, mesh.meshlets);
+    copyBlock(file, header.meshletVertexOffset, mesh.meshletVertices);
+    copyBlock(file, header.meshletTriangleOffset, mesh.meshletTriangles);
+    header.checksum = checksum(file.data() + header.positionOffset, header.fileSize - header.positionOffset);
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    // write next to the target and rename so a reader never maps a half-written file
+    std::string temporaryPath = cachePath + ".tmp";
+    {
+        std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cout << "Failed to write the mesh cache: " << cachePath << std::endl;
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(file.data()), file.size());
+        if (!out.good()) {
+            std::cout << "Failed to write the mesh cache: " << cachePath << std::endl;
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+    }
+    return std::rename(temporaryPath.c_str(), cachePath.c_str()) == 0;
+}
+
+bool mapMeshCache(const std::string& cachePath, uint64_t sourceSize, int64_t sourceModified, MappedMesh& out) {
+    out.release();
+
+    int fd = open(cachePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(MeshCacheHeader)) {
+        close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(mapping);
+    MeshCacheHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+
+    bool valid = std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) == 0
+        && header.version == MESH_CACHE_VERSION
+        && header.headerSize == sizeof(MeshCacheHeader)
+        && header.sourceSize == sourceSize
+        && header.sourceModified == sourceModified
+        && header.fileSize == size
+        && header.positionOffset % MESH_CACHE_ALIGNMENT == 0
+        && header.normalOffset % MESH_CACHE_ALIGNMENT == 0
+        && header.texCoordOffset % MESH_CACHE_ALIGNMENT == 0
+        && header.indexOffset % MESH_CACHE_ALIGNMENT == 0
+        && header.lodOffset % MESH_CACHE_ALIGNMENT == 0
+        && header.meshletOffset % MESH_CACHE_ALIGNMENT == 0
+        && header.meshletVertexOffset % MESH_CACHE_ALIGNMENT == 0
+        && header.meshletTriangleOffset % MESH_CACHE_ALIGNMENT == 0
+        && header.positionOffset >= sizeof(MeshCacheHeader)
+        && header.positionOffset + header.vertexCount * sizeof(glm::vec3) <= header.normalOffset
+        && header.normalOffset + header.vertexCount * sizeof(glm::vec3) <= header.texCoordOffset
+        && header.texCoordOffset + header.vertexCount * sizeof(glm::vec2) <= header.indexOffset
+        && header.indexOffset + header.indexCount * sizeof(uint32_t) <= header.lodOffset
+        && header.lodOffset + header.lodCount * sizeof(MeshLod) <= header.meshletOffset
+        && header.meshletOffset + header.meshletCount * sizeof(Meshlet) <= header.meshletVertexOffset
+        && header.meshletVertexOffset + header.meshletVertexCount * sizeof(uint32_t) <= header.meshletTriangleOffset
+        && header.meshletTriangleOffset + header.meshletTriangleCount * sizeof(uint8_t) <= size;
+    if (valid) {
+        valid = checksum(bytes + header.positionOffset, size - header.positionOffset) == header.checksum;
+    }
+    if (!valid) {
+        munmap(mapping, size);
+        return false;
+    }
+
+    out.mapping = mapping;
+    out.mappingSize = size;
+    out.mesh.streams.positions = Span<glm::vec3>(reinterpret_cast<const glm::vec3*>(bytes + header.positionOffset), header.vertexCount);
+    out.mesh.streams.normals = Span<glm::vec3>(reinterpret_cast<const glm::vec3*>(bytes + header.normalOffset), header.vertexCount);
+    out.mesh.streams.texCoords = Span<glm::vec2>(reinterpret_cast<const glm::vec2*>(bytes + header.texCoordOffset), header.vertexCount);
+    out.mesh.indices = Span<uint32_t>(reinterpret_cast<const uint32_t*>(bytes + header.indexOffset), header.indexCount);
+    out.mesh.lods = Span<MeshLod>(reinterpret_cast<const MeshLod*>(bytes + header.lodOffset), header.lodCount);
+    out.mesh.meshlets = Span<Meshlet>(reinterpret_cast<const Meshlet*>(bytes + header.meshletOffset), header.meshletCount);
+    out.mesh.meshletVertices = Span<uint32_t>(reinterpret_cast<const uint32_t*>(bytes + header.meshletVertexOffset), header.meshletVertexCount);
+    out.mesh.meshletTriangles = Span<uint8_t>(reinterpret_cast<const uint8_t*>(bytes + header.meshletTriangleOffset), header.meshletTriangleCount);
+    out.mesh.boundsCenter = glm::vec3(header.boundsCenter[0], header.boundsCenter[1], header.boundsCenter[2]);
+    out.mesh.boundsRadius = header.boundsRadius;
+    return true;
+}
+
+struct CornerHash {
+    size_t operator()(const std::array<int, 3>& corner) const {
+        uint64_t hash = static_cast<uint32_t>(corner[0]);
+        hash = hash * 0x9E3779B97F4A7C15ull + static_cast<uint32_t>(corner[1]);
+        hash = hash * 0x9E3779B97F4A7C15ull + static_cast<uint32_t>(corner[2]);
+        return static_cast<size_t>(hash ^ (hash >> 29));
+    }
+};
+
+static bool buildMeshData(const std::string& objPath, MeshData& mesh) {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec3> texCoords;
+    std::vector<Face> faces;
+
+    if (!triangleFill(objPath, vertices, normals, texCoords, faces)) {
+        return false;
+    }
+
+    // corners that share position, texcoord and normal become one vertex, so
+    // the vertex stage transforms each of them once
+    std::unordered_map<std::array<int, 3>, uint32_t, CornerHash> uniqueCorners;
+    uniqueCorners.reserve(faces.size() * 3);
+    mesh.indices.reserve(faces.size() * 3);
+    for (const auto& face : faces) {
+        for (int i = 0; i < 3; ++i) {
+            std::array<int, 3> corner = {face.vertexIndices[i], face.texIndices[i], face.normalIndices[i]};
+            auto inserted = uniqueCorners.emplace(corner, static_cast<uint32_t>(mesh.positions.size()));
+            if (inserted.second) {
+                mesh.positions.push_back(vertices[face.vertexIndices[i]]);
+                mesh.normals.push_back(normals[face.normalIndices[i]]);
+                mesh.texCoords.push_back(glm::vec2(texCoords[face.texIndices[i]]));
+            }
+            mesh.indices.push_back(inserted.first->second);
+        }
+    }
+
+    computeBounds(mesh);
+    buildLodChain(mesh);
+    optimizeMesh(mesh, objPath);
+    buildMeshlets(mesh);
+    return true;
+}
+
+bool loadMeshCache(const std::string& objPath, MappedMesh& out) {
+    uint64_t sourceSize;
+    int64_t sourceModified;
+    if (!sourceStamp(objPath, sourceSize, sourceModified)) {
+        std::cout << "Failed to open the file: " << objPath << std::endl;
+        return false;
+    }
+
+    std::string cachePath = meshCachePath(objPath);
+    if (mapMeshCache(cachePath, sourceSize, sourceModified, out)) {
+        return true;
+    }
+
+    MeshData mesh;
+    if (!buildMeshData(objPath, mesh)) {
+        return false;
+    }
+    if (writeMeshCache(cachePath, mesh.view(), sourceSize, sourceModified)
+        && mapMeshCache(cachePath, sourceSize, sourceModified, out)) {
+        return true;
+    }
+
+    std::cout << "Could not use the mesh cache, keeping the mesh in memory: " << cachePath << std::endl;
+    out.release();
+    out.owned = std::move(mesh);
+    out.mesh = out.owned.view();
+    return true;
+}
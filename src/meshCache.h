@@ -0,0 +1,77 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: meshCache.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "mesh.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+constexpr uint32_t MESH_CACHE_VERSION = 6;
+constexpr size_t MESH_CACHE_ALIGNMENT = 64;
+
+// on-disk layout: header, then each block starts on a MESH_CACHE_ALIGNMENT boundary
+struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t sourceSize;
+    int64_t sourceModified;  // nanoseconds, from the OBJ the cache was built from
+    uint64_t vertexCount;
+    uint64_t positionOffset; // glm::vec3 per vertex
+    uint64_t normalOffset;   // glm::vec3 per vertex
+    uint64_t texCoordOffset; // glm::vec2 per vertex
+    uint64_t indexCount;     // three per triangle, all levels of detail
+    uint64_t indexOffset;
+    uint64_t lodCount;
+    uint64_t lodOffset;      // MeshLod per level, finest first
+    uint64_t meshletCount;
+    uint64_t meshletOffset;  // Meshlet per cluster, every level back to back
+    uint64_t meshletVertexCount;
+    uint64_t meshletVertexOffset;   // uint32_t mesh vertex index per meshlet vertex
+    uint64_t meshletTriangleCount;
+    uint64_t meshletTriangleOffset; // uint8_t meshlet vertex index, three per triangle
+    float boundsCenter[3];
+    float boundsRadius;
+    uint64_t fileSize;
+    uint64_t checksum;       // over everything after the header
+};
+
+// a cache file mapped read-only; the view points straight into the mapping,
+// or into the owned data when the cache could not be written
+struct MappedMesh {
+    MeshView mesh;
+
+    MappedMesh() = default;
+    ~MappedMesh();
+    MappedMesh(const MappedMesh&) = delete;
+    MappedMesh& operator=(const MappedMesh&) = delete;
+
+    void release();
+
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    MeshData owned;
+};
+
+std::string meshCachePath(const std::string& objPath);
+
+bool writeMeshCache(
+  const std::string& cachePath,
+  const MeshView& mesh,
+  uint64_t sourceSize,
+  int64_t sourceModified
+);
+
+bool mapMeshCache(const std::string& cachePath, uint64_t sourceSize, int64_t sourceModified, MappedMesh& out);
+
+// maps the cache next to objPath, rebuilding it from the OBJ first when it is
+// missing, corrupt or older than the source
+bool loadMeshCache(const std::string& objPath, MappedMesh& out);
@@ -0,0 +1,436 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: meshLod.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "meshLod.h"
+#include <array>
+#include <queue>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+
+// symmetric 4x4 matrix of the summed plane equations around a vertex
+struct Quadric {
+    double xx = 0, xy = 0, xz = 0, xw = 0, yy = 0, yz = 0, yw = 0, zz = 0, zw = 0, ww = 0;
+
+    void addPlane(const glm::dvec3& n, double d) {
+        xx += n.x * n.x; xy += n.x * n.y; xz += n.x * n.z; xw += n.x * d;
+        yy += n.y * n.y; yz += n.y * n.z; yw += n.y * d;
+        zz += n.z * n.z; zw += n.z * d;
+        ww += d * d;
+    }
+
+    void add(const Quadric& q) {
+        xx += q.xx; xy += q.xy; xz += q.xz; xw += q.xw;
+        yy += q.yy; yz += q.yz; yw += q.yw;
+        zz += q.zz; zw += q.zw;
+        ww += q.ww;
+    }
+
+    double evaluate(const glm::vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        return x * x * xx + 2 * x * y * xy + 2 * x * z * xz + 2 * x * xw
+            + y * y * yy + 2 * y * z * yz + 2 * y * yw
+            + z * z * zz + 2 * z * zw
+            + ww;
+    }
+};
+
+struct Collapse {
+    double cost;
+    uint32_t from;
+    uint32_t to;
+    uint32_t fromVersion;
+    uint32_t toVersion;
+
+    bool operator>(const Collapse& other) const { return cost > other.cost; }
+};
+
+struct PositionHash {
+    size_t operator()(const std::array<uint32_t, 3>& bits) const {
+        uint64_t hash = bits[0];
+        hash = hash * 0x9E3779B97F4A7C15ull + bits[1];
+        hash = hash * 0x9E3779B97F4A7C15ull + bits[2];
+        return static_cast<size_t>(hash ^ (hash >> 31));
+    }
+};
+
+void computeBounds(MeshData& mesh) {
+    if (mesh.positions.empty()) {
+        mesh.boundsCenter = glm::vec3(0.0f);
+        mesh.boundsRadius = 0.0f;
+        return;
+    }
+    glm::vec3 low = mesh.positions[0];
+    glm::vec3 high = mesh.positions[0];
+    for (const glm::vec3& p : mesh.positions) {
+        low = glm::min(low, p);
+        high = glm::max(high, p);
+    }
+    mesh.boundsCenter = (low + high) * 0.5f;
+    float radius = 0.0f;
+    for (const glm::vec3& p : mesh.positions) {
+        radius = std::max(radius, glm::length(p - mesh.boundsCenter));
+    }
+    mesh.boundsRadius = radius;
+}
+
+namespace {
+
+// collapses happen between welded positions ("reps"); the vertices sharing a
+// position (seams in texcoords or normals) are its wedges
+class Simplifier {
+public:
+    Simplifier(const MeshData& mesh, const std::vector<uint32_t>& indices) : mesh(mesh) {
+        size_t vertexCount = mesh.positions.size();
+        rep.assign(vertexCount, UINT32_MAX);
+        wedges.resize(vertexCount);
+        trianglesOf.resize(vertexCount);
+        quadrics.resize(vertexCount);
+        dead.assign(vertexCount, false);
+        locked.assign(vertexCount, false);
+        version.assign(vertexCount, 0);
+
+        std::unordered_map<std::array<uint32_t, 3>, uint32_t, PositionHash> welded;
+        for (uint32_t index : indices) {
+            if (rep[index] != UINT32_MAX) {
+                continue;
+            }
+            std::array<uint32_t, 3> bits;
+            std::memcpy(bits.data(), &mesh.positions[index].x, sizeof(bits));
+            auto inserted = welded.emplace(bits, index);
+            rep[index] = inserted.first->second;
+            wedges[rep[index]].push_back(index);
+        }
+
+        corners.resize(indices.size() / 3);
+        alive.assign(corners.size(), true);
+        aliveCount = corners.size();
+
+        std::unordered_map<uint64_t, int> edgeUse;
+        for (size_t t = 0; t < corners.size(); ++t) {
+            for (int k = 0; k < 3; ++k) {
+                corners[t][k] = indices[3 * t + k];
+            }
+            std::array<uint32_t, 3> r = reps(t);
+            glm::dvec3 p0(mesh.positions[r[0]]);
+            glm::dvec3 p1(mesh.positions[r[1]]);
+            glm::dvec3 p2(mesh.positions[r[2]]);
+            glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+            double length = glm::length(n);
+            if (length > 0.0) {
+                n = n / length;
+                Quadric plane;
+                plane.addPlane(n, -glm::dot(n, p0));
+                for (int k = 0; k < 3; ++k) {
+                    quadrics[r[k]].add(plane);
+                }
+            }
+            for (int k = 0; k < 3; ++k) {
+                trianglesOf[r[k]].push_back(static_cast<uint32_t>(t));
+                edgeUse[edgeKey(r[k], r[(k + 1) % 3])]++;
+            }
+        }
+
+        // open borders and non-manifold edges stay where they are
+        for (const auto& edge : edgeUse) {
+            if (edge.second != 2) {
+                locked[static_cast<uint32_t>(edge.first >> 32)] = true;
+                locked[static_cast<uint32_t>(edge.first & 0xffffffffu)] = true;
+            }
+        }
+        for (const auto& edge : edgeUse) {
+            uint32_t a = static_cast<uint32_t>(edge.first >> 32);
+            uint32_t b = static_cast<uint32_t>(edge.first & 0xffffffffu);
+            pushCandidate(a, b);
+            pushCandidate(b, a);
+        }
+    }
+
+    float run(size_t targetTriangles) {
+        double maxCost = 0.0;
+        while (aliveCount > targetTriangles && !heap.empty()) {
+            Collapse collapse = heap.top();
+            heap.pop();
+            if (dead[collapse.from] || dead[collapse.to]
+                || version[collapse.from] != collapse.fromVersion || version[collapse.to] != collapse.toVersion) {
+                continue;
+            }
+            if (!canCollapse(collapse.from, collapse.to)) {
+                continue;
+            }
+            apply(collapse.from, collapse.to);
+            maxCost = std::max(maxCost, collapse.cost);
+        }
+        return static_cast<float>(std::sqrt(maxCost));
+    }
+
+    void output(std::vector<uint32_t>& out) const {
+        out.clear();
+        out.reserve(aliveCount * 3);
+        for (size_t t = 0; t < corners.size(); ++t) {
+            if (alive[t]) {
+                out.insert(out.end(), corners[t].begin(), corners[t].end());
+            }
+        }
+    }
+
+private:
+    static uint64_t edgeKey(uint32_t a, uint32_t b) {
+        if (a > b) {
+            std::swap(a, b);
+        }
+        return (static_cast<uint64_t>(a) << 32) | b;
+    }
+
+    std::array<uint32_t, 3> reps(size_t t) const {
+        return {rep[corners[t][0]], rep[corners[t][1]], rep[corners[t][2]]};
+    }
+
+    void pushCandidate(uint32_t from, uint32_t to) {
+        if (locked[from] || from == to) {
+            return;
+        }
+        Quadric combined = quadrics[from];
+        combined.add(quadrics[to]);
+        double cost = std::max(0.0, combined.evaluate(mesh.positions[to]));
+        heap.push(Collapse{cost, from, to, version[from], version[to]});
+    }
+
+    void neighbors(uint32_t r, std::vector<uint32_t>& out) const {
+        out.clear();
+        for (uint32_t t : trianglesOf[r]) {
+            if (!alive[t]) {
+                continue;
+            }
+            for (uint32_t n : reps(t)) {
+                if (n != r) {
+                    out.push_back(n);
+                }
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    bool canCollapse(uint32_t from, uint32_t to) {
+        // the edge must still exist, and the two fans may only share the two
+        // vertices opposite it, otherwise the collapse pinches the surface
+        neighbors(from, fromNeighbors);
+        neighbors(to, toNeighbors);
+        if (!std::binary_search(fromNeighbors.begin(), fromNeighbors.end(), to)) {
+            return false;
+        }
+        size_t shared = 0;
+        for (uint32_t n : fromNeighbors) {
+            shared += std::binary_search(toNeighbors.begin(), toNeighbors.end(), n) ? 1 : 0;
+        }
+        if (shared > 2) {
+            return false;
+        }
+
+        // no remaining triangle may flip or collapse to a sliver
+        for (uint32_t t : trianglesOf[from]) {
+            if (!alive[t]) {
+                continue;
+            }
+            std::array<uint32_t, 3> r = reps(t);
+            if (r[0] == to || r[1] == to || r[2] == to) {
+                continue;
+            }
+            glm::vec3 before[3];
+            glm::vec3 after[3];
+            for (int k = 0; k < 3; ++k) {
+                before[k] = mesh.positions[r[k]];
+                after[k] = r[k] == from ? mesh.positions[to] : before[k];
+            }
+            glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            float lengthBefore = glm::length(normalBefore);
+            float lengthAfter = glm::length(normalAfter);
+            if (lengthAfter <= 1e-12f || lengthBefore <= 1e-12f) {
+                return false;
+            }
+            if (glm::dot(normalBefore, normalAfter) < 0.25f * lengthBefore * lengthAfter) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // the wedge of `to` whose attributes are closest to the wedge being replaced
+    uint32_t closestWedge(uint32_t wedge, uint32_t to) const {
+        uint32_t best = to;
+        float bestDistance = INFINITY;
+        for (uint32_t candidate : wedges[to]) {
+            glm::vec2 dt = mesh.texCoords[candidate] - mesh.texCoords[wedge];
+            glm::vec3 dn = mesh.normals[candidate] - mesh.normals[wedge];
+            float distance = glm::dot(dt, dt) + glm::dot(dn, dn);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = candidate;
+            }
+        }
+        return best;
+    }
+
+    void apply(uint32_t from, uint32_t to) {
+        for (uint32_t t : trianglesOf[from]) {
+            if (!alive[t]) {
+                continue;
+            }
+            std::array<uint32_t, 3> r = reps(t);
+            if (r[0] == to || r[1] == to || r[2] == to) {
+                alive[t] = false;
+                --aliveCount;
+                continue;
+            }
+            for (int k = 0; k < 3; ++k) {
+                if (r[k] == from) {
+                    corners[t][k] = closestWedge(corners[t][k], to);
+                }
+            }
+            trianglesOf[to].push_back(t);
+        }
+        trianglesOf[from].clear();
+        quadrics[to].add(quadrics[from]);
+        dead[from] = true;
+        ++version[to];
+
+        auto& fan = trianglesOf[to];
+        fan.erase(std::remove_if(fan.begin(), fan.end(), [&](uint32_t t) { return !alive[t]; }), fan.end());
+
+        neighbors(to, toNeighbors);
+        for (uint32_t n : toNeighbors) {
+            pushCandidate(to, n);
+            pushCandidate(n, to);
+        }
+    }
+
+    const MeshData& mesh;
+    std::vector<uint32_t> rep;
+    std::vector<std::vector<uint32_t>> wedges;
+    std::vector<std::vector<uint32_t>> trianglesOf;
+    std::vector<Quadric> quadrics;
+    std::vector<bool> dead;
+    std::vector<bool> locked;
+    std::vector<uint32_t> version;
+    std::vector<std::array<uint32_t, 3>> corners;
+    std::vector<bool> alive;
+    size_t aliveCount = 0;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+    std::vector<uint32_t> fromNeighbors;
+    std::vector<uint32_t> toNeighbors;
+};
+
+}
+
+float simplifyIndices(const MeshData& mesh, const std::vector<uint32_t>& indices, size_t targetTriangles, std::vector<uint32_t>& out) {
+    Simplifier simplifier(mesh, indices);
+    float error = simplifier.run(targetTriangles);
+    simplifier.output(out);
+    return error;
+}
+
+void buildLodChain(MeshData& mesh, const LodSettings& settings) {
+    if (mesh.indices.empty()) {
+        mesh.lods.clear();
+        return;
+    }
+    if (mesh.boundsRadius <= 0.0f) {
+        computeBounds(mesh);
+    }
+
+    std::vector<std::vector<uint32_t>> levels{mesh.indices};
+    std::vector<float> errors{0.0f};
+    while (levels.size() < settings.maxLevels) {
+        size_t triangles = levels.back().size() / 3;
+        size_t target = static_cast<size_t>(triangles * settings.reduction);
+        if (target < settings.minTriangles) {
+            break;
+        }
+        std::vector<uint32_t> next;
+        float error = simplifyIndices(mesh, levels.back(), target, next);
+        // stop once the simplifier is blocked by locked or flipping collapses
+        if (next.size() / 3 > triangles - (triangles - target) / 2) {
+            break;
+        }
+        errors.push_back(errors.back() + error);
+        levels.push_back(std::move(next));
+    }
+
+    // coarser levels only ever drop vertices, so sorting vertices by the
+    // coarsest level that still uses them makes every level a prefix
+    size_t vertexCount = mesh.positions.size();
+    std::vector<int> coarsest(vertexCount, -1);
+    for (size_t level = 0; level < levels.size(); ++level) {
+        for (uint32_t index : levels[level]) {
+            coarsest[index] = static_cast<int>(level);
+        }
+    }
+    std::vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return coarsest[a] > coarsest[b]; });
+
+    std::vector<uint32_t> remap(vertexCount);
+    MeshData sorted;
+    sorted.positions.resize(vertexCount);
+    sorted.normals.resize(vertexCount);
+    sorted.texCoords.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        remap[order[i]] = static_cast<uint32_t>(i);
+        sorted.positions[i] = mesh.positions[order[i]];
+        sorted.normals[i] = mesh.normals[order[i]];
+        sorted.texCoords[i] = mesh.texCoords[order[i]];
+    }
+
+    mesh.positions = std::move(sorted.positions);
+    mesh.normals = std::move(sorted.normals);
+    mesh.texCoords = std::move(sorted.texCoords);
+    mesh.indices.clear();
+    mesh.lods.clear();
+    for (size_t level = 0; level < levels.size(); ++level) {
+        MeshLod lod{};
+        lod.indexOffset = static_cast<uint32_t>(mesh.indices.size());
+        lod.indexCount = static_cast<uint32_t>(levels[level].size());
+        lod.vertexCount = static_cast<uint32_t>(std::count_if(coarsest.begin(), coarsest.end(), [&](int c) { return c >= static_cast<int>(level); }));
+        lod.error = errors[level];
+        for (uint32_t index : levels[level]) {
+            mesh.indices.push_back(remap[index]);
+        }
+        mesh.lods.push_back(lod);
+    }
+}
+
+float projectedRadius(const MeshView& mesh, const Uniforms& uniforms) {
+    glm::mat3 linear = glm::mat3(uniforms.model);
+    float scale = std::max(glm::length(linear[0]), std::max(glm::length(linear[1]), glm::length(linear[2])));
+    glm::vec4 center = uniforms.view * uniforms.model * glm::vec4(mesh.boundsCenter, 1.0f);
+    float radius = mesh.boundsRadius * scale;
+    float depth = -center.z;
+    if (depth <= radius) {
+        return INFINITY;
+    }
+    // projection[1][1] is cot(fov / 2) and viewport[1][1] half the screen height
+    return radius * uniforms.projection[1][1] * uniforms.viewport[1][1] / depth;
+}
+
+size_t selectLod(const MeshView& mesh, float screenRadius, float errorPixels) {
+    if (mesh.lods.empty() || mesh.boundsRadius <= 0.0f) {
+        return 0;
+    }
+    float pixelsPerUnit = screenRadius / mesh.boundsRadius;
+    for (size_t level = mesh.lods.size() - 1; level > 0; --level) {
+        if (mesh.lods[level].error * pixelsPerUnit <= errorPixels) {
+            return level;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,38 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: meshLod.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "mesh.h"
+#include "fragment.h"
+#include <vector>
+#include <cstdint>
+
+// a level is drawn once its error projects to less than this many pixels
+constexpr float LOD_ERROR_PIXELS = 1.0f;
+
+struct LodSettings {
+    size_t maxLevels = 6;
+    float reduction = 0.5f;      // triangle count of each level relative to the previous one
+    size_t minTriangles = 32;
+};
+
+void computeBounds(MeshData& mesh);
+
+// quadric error edge collapse of one index list down to roughly targetTriangles;
+// returns the largest collapse error (object-space distance)
+float simplifyIndices(const MeshData& mesh, const std::vector<uint32_t>& indices, size_t targetTriangles, std::vector<uint32_t>& out);
+
+// replaces mesh.indices with a chain of levels and reorders the vertices so
+// each level reads a prefix of the streams
+void buildLodChain(MeshData& mesh, const LodSettings& settings = LodSettings());
+
+// radius of the mesh's bounding sphere on screen, in pixels
+float projectedRadius(const MeshView& mesh, const Uniforms& uniforms);
+
+size_t selectLod(const MeshView& mesh, float screenRadius, float errorPixels = LOD_ERROR_PIXELS);
@@ -0,0 +1,271 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: meshOptimize.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "meshOptimize.h"
+#include <cmath>
+#include <numeric>
+#include <iostream>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+// clusters smaller than this are merged so the reorder keeps most of the cache reuse
+constexpr size_t MIN_CLUSTER_TRIANGLES = 32;
+
+VertexCacheMetrics analyzeVertexCache(Span<uint32_t> indices, size_t vertexCount, size_t cacheSize) {
+    VertexCacheMetrics metrics;
+    if (indices.empty()) {
+        return metrics;
+    }
+
+    std::vector<uint64_t> insertedAt(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    uint64_t time = cacheSize + 1;
+    size_t misses = 0;
+    size_t unique = 0;
+    for (uint32_t index : indices) {
+        if (!referenced[index]) {
+            referenced[index] = true;
+            ++unique;
+        }
+        if (time - insertedAt[index] > cacheSize) {
+            insertedAt[index] = time++;
+            ++misses;
+        }
+    }
+
+    metrics.acmr = static_cast<float>(misses) / (indices.size() / 3);
+    metrics.atvr = static_cast<float>(misses) / unique;
+    return metrics;
+}
+
+void optimizeVertexCache(Span<uint32_t> indices, size_t vertexCount, std::vector<uint32_t>& out, std::vector<size_t>* clusterStarts, size_t cacheSize) {
+    size_t triangleCount = indices.size() / 3;
+    out.clear();
+    out.reserve(indices.size());
+    if (clusterStarts) {
+        clusterStarts->clear();
+    }
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // vertex -> triangles adjacency in compressed rows
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (uint32_t index : indices) {
+        ++liveTriangles[index];
+    }
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (int k = 0; k < 3; ++k) {
+            adjacency[fill[indices[3 * t + k]]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<uint64_t> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    uint64_t time = cacheSize + 1;
+    size_t cursor = 0;
+
+    auto skipDeadEnd = [&]() -> int64_t {
+        while (!deadEnds.empty()) {
+            uint32_t v = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[v] > 0) {
+                return v;
+            }
+        }
+        while (cursor < vertexCount) {
+            if (liveTriangles[cursor] > 0) {
+                return static_cast<int64_t>(cursor);
+            }
+            ++cursor;
+        }
+        return -1;
+    };
+
+    int64_t fanning = skipDeadEnd();
+    if (clusterStarts) {
+        clusterStarts->push_back(0);
+    }
+    while (fanning >= 0) {
+        candidates.clear();
+        for (uint32_t a = adjacencyOffset[fanning]; a < adjacencyOffset[fanning + 1]; ++a) {
+            uint32_t t = adjacency[a];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = true;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = indices[3 * t + k];
+                out.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                --liveTriangles[v];
+                if (time - cacheTime[v] > cacheSize) {
+                    cacheTime[v] = time++;
+                }
+            }
+        }
+
+        // prefer the candidate whose remaining fan still fits in the cache and
+        // that entered the cache earliest
+        int64_t next = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (liveTriangles[v] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (static_cast<int64_t>(time - cacheTime[v]) + 2 * static_cast<int64_t>(liveTriangles[v]) <= static_cast<int64_t>(cacheSize)) {
+                priority = static_cast<int64_t>(time - cacheTime[v]);
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+        if (next < 0) {
+            next = skipDeadEnd();
+            if (next >= 0 && clusterStarts && out.size() / 3 > clusterStarts->back()) {
+                clusterStarts->push_back(out.size() / 3);
+            }
+        }
+        fanning = next;
+    }
+}
+
+void optimizeOverdraw(Span<uint32_t> indices, Span<glm::vec3> positions, const std::vector<size_t>& clusterStarts, std::vector<uint32_t>& out) {
+    size_t triangleCount = indices.size() / 3;
+    out.assign(indices.begin(), indices.end());
+    if (triangleCount == 0 || clusterStarts.empty()) {
+        return;
+    }
+
+    std::vector<size_t> starts;
+    for (size_t start : clusterStarts) {
+        if (starts.empty() || start - starts.back() >= MIN_CLUSTER_TRIANGLES) {
+            starts.push_back(start);
+        }
+    }
+    if (triangleCount - starts.back() < MIN_CLUSTER_TRIANGLES && starts.size() > 1) {
+        starts.pop_back();
+    }
+    starts.push_back(triangleCount);
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> clusterCentroid(starts.size() - 1, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormal(starts.size() - 1, glm::vec3(0.0f));
+    std::vector<float> clusterArea(starts.size() - 1, 0.0f);
+    for (size_t c = 0; c + 1 < starts.size(); ++c) {
+        for (size_t t = starts[c]; t < starts[c + 1]; ++t) {
+            glm::vec3 a = positions[indices[3 * t]];
+            glm::vec3 b = positions[indices[3 * t + 1]];
+            glm::vec3 d = positions[indices[3 * t + 2]];
+            glm::vec3 normal = glm::cross(b - a, d - a);
+            float area = glm::length(normal);
+            glm::vec3 centroid = (a + b + d) / 3.0f;
+            clusterCentroid[c] += centroid * area;
+            clusterNormal[c] += normal;
+            clusterArea[c] += area;
+            meshCentroid += centroid * area;
+            meshArea += area;
+        }
+    }
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+
+    // clusters facing away from the mesh center are drawn first (Sander et al.)
+    std::vector<float> sortKey(starts.size() - 1, 0.0f);
+    for (size_t c = 0; c < sortKey.size(); ++c) {
+        if (clusterArea[c] <= 0.0f || glm::length(clusterNormal[c]) <= 0.0f) {
+            continue;
+        }
+        glm::vec3 centroid = clusterCentroid[c] / clusterArea[c];
+        sortKey[c] = glm::dot(centroid - meshCentroid, glm::normalize(clusterNormal[c]));
+    }
+    std::vector<size_t> order(sortKey.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+    out.clear();
+    for (size_t c : order) {
+        out.insert(out.end(), indices.begin() + 3 * starts[c], indices.begin() + 3 * starts[c + 1]);
+    }
+}
+
+void optimizeMesh(MeshData& mesh, const std::string& name) {
+    if (mesh.indices.empty()) {
+        return;
+    }
+    if (mesh.lods.empty()) {
+        mesh.lods.push_back(MeshLod{0, static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(mesh.positions.size()), 0.0f, 0, 0});
+    }
+
+    Span<uint32_t> finest = Span<uint32_t>(mesh.indices).subspan(mesh.lods[0].indexOffset, mesh.lods[0].indexCount);
+    VertexCacheMetrics before = analyzeVertexCache(finest, mesh.positions.size());
+
+    std::vector<uint32_t> tipsified;
+    std::vector<uint32_t> reordered;
+    std::vector<size_t> clusterStarts;
+    for (const MeshLod& lod : mesh.lods) {
+        Span<uint32_t> level = Span<uint32_t>(mesh.indices).subspan(lod.indexOffset, lod.indexCount);
+        optimizeVertexCache(level, lod.vertexCount, tipsified, &clusterStarts);
+        optimizeOverdraw(tipsified, mesh.positions, clusterStarts, reordered);
+        std::copy(reordered.begin(), reordered.end(), mesh.indices.begin() + lod.indexOffset);
+    }
+
+    // the vertices only a level and the finer ones use sit in one band of the
+    // streams; each band is put in the order that level first reads them
+    size_t vertexCount = mesh.positions.size();
+    std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+    uint32_t next = 0;
+    for (size_t level = mesh.lods.size(); level-- > 0;) {
+        const MeshLod& lod = mesh.lods[level];
+        for (uint32_t i = 0; i < lod.indexCount; ++i) {
+            uint32_t index = mesh.indices[lod.indexOffset + i];
+            if (remap[index] == UINT32_MAX) {
+                remap[index] = next++;
+            }
+        }
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (remap[v] == UINT32_MAX) {
+            remap[v] = next++;
+        }
+    }
+
+    std::vector<glm::vec3> positions(vertexCount);
+    std::vector<glm::vec3> normals(vertexCount);
+    std::vector<glm::vec2> texCoords(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        positions[remap[v]] = mesh.positions[v];
+        normals[remap[v]] = mesh.normals[v];
+        texCoords[remap[v]] = mesh.texCoords[v];
+    }
+    mesh.positions = std::move(positions);
+    mesh.normals = std::move(normals);
+    mesh.texCoords = std::move(texCoords);
+    for (uint32_t& index : mesh.indices) {
+        index = remap[index];
+    }
+
+    VertexCacheMetrics after = analyzeVertexCache(finest, mesh.positions.size());
+    std::cout << "Optimized mesh " << name
+        << ": ACMR " << before.acmr << " -> " << after.acmr
+        << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+}
@@ -0,0 +1,36 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: meshOptimize.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "mesh.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+constexpr size_t VERTEX_CACHE_SIZE = 16;
+
+struct VertexCacheMetrics {
+    float acmr = 0.0f;  // cache misses per triangle, 0.5 is the ideal for large meshes
+    float atvr = 0.0f;  // cache misses per referenced vertex, 1.0 is the ideal
+};
+
+// simulates a FIFO post-transform cache of the given size over a triangle list
+VertexCacheMetrics analyzeVertexCache(Span<uint32_t> indices, size_t vertexCount, size_t cacheSize = VERTEX_CACHE_SIZE);
+
+// Tipsify triangle order; clusterStarts receives the triangle index of every
+// point where the walk had to jump to an unrelated part of the mesh
+void optimizeVertexCache(Span<uint32_t> indices, size_t vertexCount, std::vector<uint32_t>& out, std::vector<size_t>* clusterStarts = nullptr, size_t cacheSize = VERTEX_CACHE_SIZE);
+
+// reorders clusters of an already cache-optimized list so outward facing ones
+// that are likely to occlude the rest are drawn first
+void optimizeOverdraw(Span<uint32_t> indices, Span<glm::vec3> positions, const std::vector<size_t>& clusterStarts, std::vector<uint32_t>& out);
+
+// runs all passes on every level of detail and reorders the vertex streams
+// by first use, keeping each level's vertices a prefix of the streams
+void optimizeMesh(MeshData& mesh, const std::string& name);
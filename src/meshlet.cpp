@@ -0,0 +1,245 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: meshlet.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "meshlet.h"
+#include <cmath>
+#include <algorithm>
+
+// a cone wider than this (about 84 degrees from the axis) can't reject anything useful
+constexpr float MIN_CONE_SPREAD = 0.1f;
+
+// never reached by a dot product of unit vectors, so the meshlet is never backfacing
+constexpr float UNCULLABLE_CONE_CUTOFF = 2.0f;
+
+static void computeMeshletBounds(const MeshData& mesh, Meshlet& meshlet) {
+    const uint32_t* vertices = &mesh.meshletVertices[meshlet.vertexOffset];
+    const uint8_t* triangles = &mesh.meshletTriangles[meshlet.triangleOffset];
+
+    glm::vec3 lower = mesh.positions[vertices[0]];
+    glm::vec3 upper = lower;
+    for (uint32_t i = 1; i < meshlet.vertexCount; ++i) {
+        lower = glm::min(lower, mesh.positions[vertices[i]]);
+        upper = glm::max(upper, mesh.positions[vertices[i]]);
+    }
+    meshlet.center = (lower + upper) * 0.5f;
+    meshlet.radius = 0.0f;
+    for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+        meshlet.radius = std::max(meshlet.radius, glm::length(mesh.positions[vertices[i]] - meshlet.center));
+    }
+
+    // normal cone: the axis averages the face normals and the cutoff is the
+    // sine of the widest angle between the axis and any face normal
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshlet.triangleCount);
+    glm::vec3 axis(0.0f);
+    for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+        glm::vec3 a = mesh.positions[vertices[triangles[3 * t]]];
+        glm::vec3 b = mesh.positions[vertices[triangles[3 * t + 1]]];
+        glm::vec3 c = mesh.positions[vertices[triangles[3 * t + 2]]];
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        if (length > 0.0f) {
+            normals.push_back(normal / length);
+            axis += normal / length;
+        }
+    }
+
+    meshlet.coneApex = meshlet.center;
+    meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    meshlet.coneCutoff = UNCULLABLE_CONE_CUTOFF;
+    meshlet.padding = 0.0f;
+    if (normals.empty() || glm::length(axis) <= 0.0f) {
+        return;
+    }
+    axis = glm::normalize(axis);
+
+    float minDot = 1.0f;
+    for (const glm::vec3& normal : normals) {
+        minDot = std::min(minDot, glm::dot(normal, axis));
+    }
+    if (minDot <= MIN_CONE_SPREAD) {
+        return;
+    }
+
+    // the apex sits behind every triangle's plane along the axis, so a camera
+    // inside the cone seen from the apex is behind all of them
+    float maxDistance = 0.0f;
+    size_t n = 0;
+    for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+        glm::vec3 a = mesh.positions[vertices[triangles[3 * t]]];
+        glm::vec3 b = mesh.positions[vertices[triangles[3 * t + 1]]];
+        glm::vec3 c = mesh.positions[vertices[triangles[3 * t + 2]]];
+        if (glm::length(glm::cross(b - a, c - a)) <= 0.0f) {
+            continue;
+        }
+        const glm::vec3& normal = normals[n++];
+        float distance = glm::dot(meshlet.center - a, normal) / glm::dot(axis, normal);
+        maxDistance = std::max(maxDistance, distance);
+    }
+
+    meshlet.coneApex = meshlet.center - axis * maxDistance;
+    meshlet.coneAxis = axis;
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+// greedy: triangles are taken in the level's (cache optimized) order and a
+// new meshlet starts whenever the next one would overflow either limit
+static void buildLevelMeshlets(MeshData& mesh, MeshLod& lod, std::vector<uint32_t>& localIndex, std::vector<uint32_t>& localOwner) {
+    lod.meshletOffset = static_cast<uint32_t>(mesh.meshlets.size());
+
+    Meshlet current{};
+    auto startMeshlet = [&]() {
+        current = Meshlet{};
+        current.vertexOffset = static_cast<uint32_t>(mesh.meshletVertices.size());
+        current.triangleOffset = static_cast<uint32_t>(mesh.meshletTriangles.size());
+    };
+    auto finishMeshlet = [&]() {
+        if (current.triangleCount > 0) {
+            computeMeshletBounds(mesh, current);
+            mesh.meshlets.push_back(current);
+        }
+    };
+
+    startMeshlet();
+    uint32_t owner = static_cast<uint32_t>(mesh.meshlets.size()) + 1;
+    for (uint32_t i = 0; i < lod.indexCount; i += 3) {
+        const uint32_t* triangle = &mesh.indices[lod.indexOffset + i];
+        uint32_t added = 0;
+        for (int k = 0; k < 3; ++k) {
+            bool repeated = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+            if (localOwner[triangle[k]] != owner && !repeated) {
+                ++added;
+            }
+        }
+        if (current.vertexCount + added > MESHLET_MAX_VERTICES || current.triangleCount + 1 > MESHLET_MAX_TRIANGLES) {
+            finishMeshlet();
+            startMeshlet();
+            ++owner;
+        }
+
+        for (int k = 0; k < 3; ++k) {
+            uint32_t vertex = triangle[k];
+            if (localOwner[vertex] != owner) {
+                localOwner[vertex] = owner;
+                localIndex[vertex] = current.vertexCount++;
+                mesh.meshletVertices.push_back(vertex);
+            }
+            mesh.meshletTriangles.push_back(static_cast<uint8_t>(localIndex[vertex]));
+        }
+        ++current.triangleCount;
+    }
+    finishMeshlet();
+
+    lod.meshletCount = static_cast<uint32_t>(mesh.meshlets.size()) - lod.meshletOffset;
+}
+
+void buildMeshlets(MeshData& mesh) {
+    mesh.meshlets.clear();
+    mesh.meshletVertices.clear();
+    mesh.meshletTriangles.clear();
+    if (mesh.indices.empty()) {
+        return;
+    }
+    if (mesh.lods.empty()) {
+        mesh.lods.push_back(MeshLod{0, static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(mesh.positions.size()), 0.0f, 0, 0});
+    }
+
+    // owner ids keep growing across levels, so the tables are never cleared
+    std::vector<uint32_t> localIndex(mesh.positions.size(), 0);
+    std::vector<uint32_t> localOwner(mesh.positions.size(), 0);
+    for (MeshLod& lod : mesh.lods) {
+        buildLevelMeshlets(mesh, lod, localIndex, localOwner);
+    }
+}
+
+MeshletCuller prepareMeshletCulling(const Uniforms& uniforms) {
+    glm::vec3 eye = glm::vec3(glm::inverse(uniforms.view) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    return prepareMeshletCulling(uniforms.projection * uniforms.view, eye, uniforms.model);
+}
+
+MeshletCuller prepareMeshletCulling(const glm::mat4& clipFromWorld, const glm::vec3& eye, const glm::mat4& model) {
+    MeshletCuller culler;
+    culler.eye = glm::vec3(glm::inverse(model) * glm::vec4(eye, 1.0f));
+
+    // planes of the clip volume -w <= x, y, z <= w pulled back into model space
+    glm::mat4 clipFromModel = clipFromWorld * model;
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; ++r) {
+        rows[r] = glm::vec4(clipFromModel[0][r], clipFromModel[1][r], clipFromModel[2][r], clipFromModel[3][r]);
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+        culler.planes[2 * axis] = rows[3] + rows[axis];
+        culler.planes[2 * axis + 1] = rows[3] - rows[axis];
+    }
+    return culler;
+}
+
+bool meshletBackfacing(const Meshlet& meshlet, const MeshletCuller& culler) {
+    glm::vec3 toApex = meshlet.coneApex - culler.eye;
+    float distance = glm::length(toApex);
+    return distance > 0.0f && glm::dot(toApex, meshlet.coneAxis) >= meshlet.coneCutoff * distance;
+}
+
+bool meshletOutside(const Meshlet& meshlet, const MeshletCuller& culler) {
+    for (const glm::vec4& plane : culler.planes) {
+        glm::vec3 normal(plane);
+        if (glm::dot(normal, meshlet.center) + plane.w < -meshlet.radius * glm::length(normal)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+MeshletCullStats cullMeshlets(const MeshView& mesh, const MeshletCuller& culler, MeshletScratch& scratch) {
+    MeshletCullStats stats;
+    scratch.indices.clear();
+    scratch.vertices.clear();
+
+    // a mesh without meshlets goes through whole
+    if (mesh.meshlets.empty()) {
+        scratch.indices.assign(mesh.indices.begin(), mesh.indices.end());
+        for (uint32_t v = 0; v < mesh.streams.size(); ++v) {
+            scratch.vertices.push_back(v);
+        }
+        return stats;
+    }
+
+    if (scratch.listedIn.size() < mesh.streams.size()) {
+        scratch.listedIn.resize(mesh.streams.size(), 0);
+    }
+    if (++scratch.draw == 0) {
+        std::fill(scratch.listedIn.begin(), scratch.listedIn.end(), 0);
+        scratch.draw = 1;
+    }
+
+    for (const Meshlet& meshlet : mesh.meshlets) {
+        if (meshletOutside(meshlet, culler)) {
+            ++stats.outside;
+            continue;
+        }
+        if (meshletBackfacing(meshlet, culler)) {
+            ++stats.backfacing;
+            continue;
+        }
+        ++stats.visible;
+
+        const uint32_t* vertices = &mesh.meshletVertices[meshlet.vertexOffset];
+        for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+            if (scratch.listedIn[vertices[i]] != scratch.draw) {
+                scratch.listedIn[vertices[i]] = scratch.draw;
+                scratch.vertices.push_back(vertices[i]);
+            }
+        }
+        const uint8_t* triangles = &mesh.meshletTriangles[meshlet.triangleOffset];
+        for (uint32_t i = 0; i < 3 * meshlet.triangleCount; ++i) {
+            scratch.indices.push_back(vertices[triangles[i]]);
+        }
+    }
+    return stats;
+}
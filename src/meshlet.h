@@ -0,0 +1,54 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: meshlet.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "mesh.h"
+#include "fragment.h"
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// local triangle indices are 8-bit, so a meshlet can't address more than 256 vertices
+constexpr size_t MESHLET_MAX_VERTICES = 64;
+constexpr size_t MESHLET_MAX_TRIANGLES = 124;
+
+// splits every level of detail into meshlets, in the level's triangle order,
+// and records each level's range in its MeshLod
+void buildMeshlets(MeshData& mesh);
+
+// camera and frustum moved into the model space of one draw
+struct MeshletCuller {
+    glm::vec3 eye;
+    glm::vec4 planes[6];  // inside when dot(plane.xyz, p) + plane.w >= 0
+};
+
+struct MeshletCullStats {
+    size_t visible = 0;
+    size_t backfacing = 0;
+    size_t outside = 0;
+};
+
+MeshletCuller prepareMeshletCulling(const Uniforms& uniforms);
+
+// for many draws sharing one camera: clipFromWorld is projection * view
+MeshletCuller prepareMeshletCulling(const glm::mat4& clipFromWorld, const glm::vec3& eye, const glm::mat4& model);
+
+bool meshletBackfacing(const Meshlet& meshlet, const MeshletCuller& culler);
+bool meshletOutside(const Meshlet& meshlet, const MeshletCuller& culler);
+
+// reused across draws; remembers which vertices were already listed this draw
+struct MeshletScratch {
+    std::vector<uint32_t> indices;   // triangles of the surviving meshlets, mesh vertex indices
+    std::vector<uint32_t> vertices;  // every vertex those triangles use, once
+    std::vector<uint32_t> listedIn;
+    uint32_t draw = 0;
+};
+
+// fills scratch with what survives culling so only those vertices get transformed
+MeshletCullStats cullMeshlets(const MeshView& mesh, const MeshletCuller& culler, MeshletScratch& scratch);
@@ -0,0 +1,94 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: morton.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "morton.h"
+#include "jobSystem.h"
+#include <algorithm>
+
+// spreads the low 21 bits of v so there are two zero bits between each of them
+static uint64_t spreadBits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+}
+
+uint64_t mortonCode(uint64_t x, uint64_t y, uint64_t z) {
+    return spreadBits(x) << 2 | spreadBits(y) << 1 | spreadBits(z);
+}
+
+// codes per block of the sort; blocks follow from the count alone, so the
+// result doesn't depend on how many threads there are
+constexpr size_t SORT_BLOCK = 65536;
+
+// least significant digit first, 8 bits per pass, skipping digits every code shares.
+// larger sorts count and scatter their blocks as separate jobs, each block
+// writing after the earlier blocks' codes of the same digit, so it stays stable
+void radixSortCodes(std::vector<uint64_t>& codes, std::vector<uint32_t>& order, std::vector<uint64_t>& codeScratch, std::vector<uint32_t>& orderScratch) {
+    size_t count = codes.size();
+    codeScratch.resize(count);
+    orderScratch.resize(count);
+    if (count == 0) {
+        return;
+    }
+    size_t blocks = (count + SORT_BLOCK - 1) / SORT_BLOCK;
+    std::vector<uint64_t> blockDiffering(blocks, 0);
+    parallelFor(blocks, 1, [&](size_t firstBlock, size_t endBlock) {
+        for (size_t block = firstBlock; block < endBlock; ++block) {
+            uint64_t differing = 0;
+            for (size_t i = block * SORT_BLOCK; i < std::min(count, (block + 1) * SORT_BLOCK); ++i) {
+                differing |= codes[i] ^ codes[0];
+            }
+            blockDiffering[block] = differing;
+        }
+    });
+    uint64_t differing = 0;
+    for (uint64_t blockBits : blockDiffering) {
+        differing |= blockBits;
+    }
+
+    std::vector<size_t> offsets(blocks * 256);  // by block, then digit
+    for (int shift = 0; shift < 3 * MORTON_BITS; shift += 8) {
+        if (((differing >> shift) & 0xff) == 0) {
+            continue;
+        }
+        parallelFor(blocks, 1, [&](size_t firstBlock, size_t endBlock) {
+            for (size_t block = firstBlock; block < endBlock; ++block) {
+                size_t* blockOffsets = &offsets[block * 256];
+                std::fill(blockOffsets, blockOffsets + 256, 0);
+                for (size_t i = block * SORT_BLOCK; i < std::min(count, (block + 1) * SORT_BLOCK); ++i) {
+                    ++blockOffsets[(codes[i] >> shift) & 0xff];
+                }
+            }
+        });
+        size_t sum = 0;
+        for (size_t digit = 0; digit < 256; ++digit) {
+            for (size_t block = 0; block < blocks; ++block) {
+                size_t bucket = offsets[block * 256 + digit];
+                offsets[block * 256 + digit] = sum;
+                sum += bucket;
+            }
+        }
+        parallelFor(blocks, 1, [&](size_t firstBlock, size_t endBlock) {
+            for (size_t block = firstBlock; block < endBlock; ++block) {
+                size_t* blockOffsets = &offsets[block * 256];
+                for (size_t i = block * SORT_BLOCK; i < std::min(count, (block + 1) * SORT_BLOCK); ++i) {
+                    size_t destination = blockOffsets[(codes[i] >> shift) & 0xff]++;
+                    codeScratch[destination] = codes[i];
+                    orderScratch[destination] = order[i];
+                }
+            }
+        });
+        codes.swap(codeScratch);
+        order.swap(orderScratch);
+    }
+}
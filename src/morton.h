@@ -0,0 +1,24 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: morton.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+constexpr int MORTON_BITS = 21;  // per axis, 63 bits in all
+
+// interleaves the low MORTON_BITS bits of each coordinate, x's highest, so
+// sorting by the code walks space along a Z-order curve
+uint64_t mortonCode(uint64_t x, uint64_t y, uint64_t z);
+
+// sorts the codes ascending and order along with them, stable and in parallel
+// for large counts; the scratch vectors are kept by the caller so sorting every
+// frame doesn't allocate more than the counts per block
+void radixSortCodes(std::vector<uint64_t>& codes, std::vector<uint32_t>& order, std::vector<uint64_t>& codeScratch, std::vector<uint32_t>& orderScratch);
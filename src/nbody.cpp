@@ -0,0 +1,403 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: nbody.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "nbody.h"
+#include "morton.h"
+#include "jobSystem.h"
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <algorithm>
+
+uint32_t NBodySystem::add(const glm::vec3& position, const glm::vec3& velocity, float bodyMass) {
+    x.push_back(position.x);
+    y.push_back(position.y);
+    z.push_back(position.z);
+    previousX.push_back(position.x);
+    previousY.push_back(position.y);
+    previousZ.push_back(position.z);
+    vx.push_back(velocity.x);
+    vy.push_back(velocity.y);
+    vz.push_back(velocity.z);
+    ax.push_back(0.0f);
+    ay.push_back(0.0f);
+    az.push_back(0.0f);
+    mass.push_back(bodyMass);
+    accelerated = false;
+    return static_cast<uint32_t>(mass.size() - 1);
+}
+
+static bool isLeaf(uint32_t count, int level, size_t leafSize) {
+    return count <= leafSize || level == MORTON_BITS;
+}
+
+// calls cell(first, count) for each child of a cell, the runs of its bodies
+// sharing the next 3 bits of their code, in order
+template <typename Cell>
+static void forEachChild(const Octree& tree, uint32_t first, uint32_t count, int level, const Cell& cell) {
+    int shift = 3 * (MORTON_BITS - 1 - level);
+    auto begin = tree.codes.begin() + first;
+    auto end = begin + count;
+    for (auto run = begin; run != end;) {
+        uint64_t prefix = *run >> shift;
+        auto runEnd = std::partition_point(run, end, [&](uint64_t code) { return (code >> shift) == prefix; });
+        cell(static_cast<uint32_t>(run - tree.codes.begin()), static_cast<uint32_t>(runEnd - run));
+        run = runEnd;
+    }
+}
+
+// appends a cell and its subtree to nodes, whose indices it uses; child(first,
+// count, level, width) builds each child and returns its index
+template <typename Child>
+static uint32_t buildCell(const Octree& tree, std::vector<OctreeNode>& nodes, uint32_t first, uint32_t count, int level, float width, size_t leafSize, const Child& child) {
+    uint32_t index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(OctreeNode{0.0f, 0.0f, 0.0f, 0.0f, width, first, count, 0, 0});
+
+    double mass = 0.0;
+    double weightedX = 0.0, weightedY = 0.0, weightedZ = 0.0;
+    double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+    if (isLeaf(count, level, leafSize)) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            mass += tree.mass[i];
+            weightedX += static_cast<double>(tree.mass[i]) * tree.x[i];
+            weightedY += static_cast<double>(tree.mass[i]) * tree.y[i];
+            weightedZ += static_cast<double>(tree.mass[i]) * tree.z[i];
+            sumX += tree.x[i];
+            sumY += tree.y[i];
+            sumZ += tree.z[i];
+        }
+        nodes[index].leaf = 1;
+    } else {
+        forEachChild(tree, first, count, level, [&](uint32_t childFirst, uint32_t childCount) {
+            const OctreeNode& node = nodes[child(childFirst, childCount, level + 1, width * 0.5f)];
+            mass += node.mass;
+            weightedX += static_cast<double>(node.mass) * node.x;
+            weightedY += static_cast<double>(node.mass) * node.y;
+            weightedZ += static_cast<double>(node.mass) * node.z;
+            sumX += static_cast<double>(node.x) * node.count;
+            sumY += static_cast<double>(node.y) * node.count;
+            sumZ += static_cast<double>(node.z) * node.count;
+        });
+    }
+
+    OctreeNode& node = nodes[index];
+    node.mass = static_cast<float>(mass);
+    if (mass > 0.0) {
+        node.x = static_cast<float>(weightedX / mass);
+        node.y = static_cast<float>(weightedY / mass);
+        node.z = static_cast<float>(weightedZ / mass);
+    } else {
+        // massless bodies only: the centroid, so parents can still average it
+        node.x = static_cast<float>(sumX / count);
+        node.y = static_cast<float>(sumY / count);
+        node.z = static_cast<float>(sumZ / count);
+    }
+    node.skip = static_cast<uint32_t>(nodes.size());
+    return index;
+}
+
+static uint32_t buildNode(const Octree& tree, std::vector<OctreeNode>& nodes, uint32_t first, uint32_t count, int level, float width, size_t leafSize) {
+    return buildCell(tree, nodes, first, count, level, width, leafSize, [&](uint32_t childFirst, uint32_t childCount, int childLevel, float childWidth) {
+        return buildNode(tree, nodes, childFirst, childCount, childLevel, childWidth, leafSize);
+    });
+}
+
+// the cells at OCTREE_JOB_LEVEL the build gets to, in the order it gets to them
+static void collectSubtrees(Octree& tree, uint32_t first, uint32_t count, int level, size_t leafSize) {
+    if (level == OCTREE_JOB_LEVEL) {
+        tree.subtreeFirst.push_back(first);
+        tree.subtreeCount.push_back(count);
+        return;
+    }
+    if (isLeaf(count, level, leafSize)) {
+        return;
+    }
+    forEachChild(tree, first, count, level, [&](uint32_t childFirst, uint32_t childCount) {
+        collectSubtrees(tree, childFirst, childCount, level + 1, leafSize);
+    });
+}
+
+// the cells above OCTREE_JOB_LEVEL, with the subtrees built below them copied
+// in where the build reaches them; the same nodes a build on one thread makes
+static uint32_t buildTopNode(Octree& tree, uint32_t first, uint32_t count, int level, float width, size_t leafSize, size_t& subtree) {
+    return buildCell(tree, tree.nodes, first, count, level, width, leafSize, [&](uint32_t childFirst, uint32_t childCount, int childLevel, float childWidth) {
+        if (childLevel < OCTREE_JOB_LEVEL) {
+            return buildTopNode(tree, childFirst, childCount, childLevel, childWidth, leafSize, subtree);
+        }
+        uint32_t base = static_cast<uint32_t>(tree.nodes.size());
+        for (OctreeNode node : tree.subtrees[subtree++]) {
+            node.skip += base;
+            tree.nodes.push_back(node);
+        }
+        return base;
+    });
+}
+
+void buildOctree(NBodySystem& system) {
+    Octree& tree = system.tree;
+    size_t count = system.size();
+    size_t leafSize = system.settings.leafSize;
+    tree.nodes.clear();
+    if (count == 0) {
+        return;
+    }
+
+    glm::vec3 low(INFINITY), high(-INFINITY);
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 position(system.x[i], system.y[i], system.z[i]);
+        low = glm::min(low, position);
+        high = glm::max(high, position);
+    }
+    float width = std::max(std::max(high.x - low.x, high.y - low.y), std::max(high.z - low.z, 1e-6f));
+    float quantize = ((1 << MORTON_BITS) - 1) / width;
+
+    tree.codes.resize(count);
+    tree.order.resize(count);
+    parallelFor(count, 16384, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint64_t qx = static_cast<uint64_t>((system.x[i] - low.x) * quantize);
+            uint64_t qy = static_cast<uint64_t>((system.y[i] - low.y) * quantize);
+            uint64_t qz = static_cast<uint64_t>((system.z[i] - low.z) * quantize);
+            tree.codes[i] = mortonCode(qx, qy, qz);
+            tree.order[i] = static_cast<uint32_t>(i);
+        }
+    });
+    radixSortCodes(tree.codes, tree.order, tree.codeScratch, tree.orderScratch);
+
+    // bodies close in space end up close in memory for the walk
+    tree.x.resize(count);
+    tree.y.resize(count);
+    tree.z.resize(count);
+    tree.mass.resize(count);
+    parallelFor(count, 16384, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t body = tree.order[i];
+            tree.x[i] = system.x[body];
+            tree.y[i] = system.y[body];
+            tree.z[i] = system.z[body];
+            tree.mass[i] = system.mass[body];
+        }
+    });
+
+    tree.nodes.reserve(2 * count / std::max<size_t>(leafSize, 1) + 1);
+    if (count < OCTREE_JOB_MIN) {
+        buildNode(tree, tree.nodes, 0, static_cast<uint32_t>(count), 0, width, leafSize);
+        return;
+    }
+
+    // the cells a few levels down are built as separate jobs, each into its own
+    // nodes, then the levels above are built over them
+    tree.subtreeFirst.clear();
+    tree.subtreeCount.clear();
+    collectSubtrees(tree, 0, static_cast<uint32_t>(count), 0, leafSize);
+    size_t subtrees = tree.subtreeFirst.size();
+    if (tree.subtrees.size() < subtrees) {
+        tree.subtrees.resize(subtrees);
+    }
+    float subtreeWidth = width / (1 << OCTREE_JOB_LEVEL);
+    parallelFor(subtrees, 1, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            tree.subtrees[k].clear();
+            buildNode(tree, tree.subtrees[k], tree.subtreeFirst[k], tree.subtreeCount[k], OCTREE_JOB_LEVEL, subtreeWidth, leafSize);
+        }
+    });
+    size_t subtree = 0;
+    buildTopNode(tree, 0, static_cast<uint32_t>(count), 0, width, leafSize, subtree);
+}
+
+void computeAccelerations(NBodySystem& system) {
+    buildOctree(system);
+    const Octree& tree = system.tree;
+    const NBodySettings& settings = system.settings;
+    float openingSquared = settings.openingAngle * settings.openingAngle;
+    float softeningSquared = settings.softening * settings.softening;
+    uint32_t nodeCount = static_cast<uint32_t>(tree.nodes.size());
+
+    // bodies only read the tree, and neighbours in Morton order walk nearly the
+    // same nodes, so contiguous ranges keep those nodes in one thread's cache
+    parallelFor(tree.order.size(), 256, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            float px = tree.x[i], py = tree.y[i], pz = tree.z[i];
+            float sumX = 0.0f, sumY = 0.0f, sumZ = 0.0f;
+            for (uint32_t n = 0; n < nodeCount;) {
+                const OctreeNode& node = tree.nodes[n];
+                float dx = node.x - px, dy = node.y - py, dz = node.z - pz;
+                float distanceSquared = dx * dx + dy * dy + dz * dz;
+                if (node.width * node.width < openingSquared * distanceSquared) {
+                    float r2 = distanceSquared + softeningSquared;
+                    float strength = node.mass / (r2 * std::sqrt(r2));
+                    sumX += dx * strength;
+                    sumY += dy * strength;
+                    sumZ += dz * strength;
+                    n = node.skip;
+                } else if (node.leaf) {
+                    // the body itself adds nothing, even without softening
+                    for (uint32_t j = node.first; j < node.first + node.count; ++j) {
+                        float bx = tree.x[j] - px, by = tree.y[j] - py, bz = tree.z[j] - pz;
+                        float r2 = bx * bx + by * by + bz * bz + softeningSquared;
+                        float strength = r2 > 0.0f ? tree.mass[j] / (r2 * std::sqrt(r2)) : 0.0f;
+                        sumX += bx * strength;
+                        sumY += by * strength;
+                        sumZ += bz * strength;
+                    }
+                    n = node.skip;
+                } else {
+                    ++n;
+                }
+            }
+            uint32_t body = tree.order[i];
+            system.ax[body] = sumX * settings.gravity;
+            system.ay[body] = sumY * settings.gravity;
+            system.az[body] = sumZ * settings.gravity;
+        }
+    });
+    system.accelerated = true;
+}
+
+glm::vec3 directAcceleration(const NBodySystem& system, size_t body) {
+    double softeningSquared = static_cast<double>(system.settings.softening) * system.settings.softening;
+    double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+    for (size_t j = 0; j < system.size(); ++j) {
+        double dx = static_cast<double>(system.x[j]) - system.x[body];
+        double dy = static_cast<double>(system.y[j]) - system.y[body];
+        double dz = static_cast<double>(system.z[j]) - system.z[body];
+        double r2 = dx * dx + dy * dy + dz * dz + softeningSquared;
+        double strength = r2 > 0.0 ? system.mass[j] / (r2 * std::sqrt(r2)) : 0.0;
+        sumX += dx * strength;
+        sumY += dy * strength;
+        sumZ += dz * strength;
+    }
+    return glm::vec3(sumX, sumY, sumZ) * system.settings.gravity;
+}
+
+void stepNBody(NBodySystem& system, float dt) {
+    if (!system.accelerated) {
+        computeAccelerations(system);
+    }
+    float half = 0.5f * dt;
+    const size_t grain = 16384;
+    parallelFor(system.size(), grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            system.vx[i] += system.ax[i] * half;
+            system.vy[i] += system.ay[i] * half;
+            system.vz[i] += system.az[i] * half;
+            system.previousX[i] = system.x[i];
+            system.previousY[i] = system.y[i];
+            system.previousZ[i] = system.z[i];
+            system.x[i] += system.vx[i] * dt;
+            system.y[i] += system.vy[i] * dt;
+            system.z[i] += system.vz[i] * dt;
+        }
+    });
+    computeAccelerations(system);
+    parallelFor(system.size(), grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            system.vx[i] += system.ax[i] * half;
+            system.vy[i] += system.ay[i] * half;
+            system.vz[i] += system.az[i] * half;
+        }
+    });
+}
+
+void nbodyFromScene(NBodySystem& system, Scene& scene, double time, const std::vector<uint32_t>& bodies, const std::vector<float>& masses) {
+    // velocities from the orbits a little before and after
+    const double h = 0.5;
+    Orbits& orbits = scene.orbits;
+    solveOrbits(orbits, time - h);
+    std::vector<float> beforeX = orbits.x, beforeY = orbits.y, beforeZ = orbits.z;
+    solveOrbits(orbits, time + h);
+    std::vector<float> afterX = orbits.x, afterY = orbits.y, afterZ = orbits.z;
+    solveOrbits(orbits, time);
+
+    float inverse = static_cast<float>(1.0 / (2.0 * h));
+    for (size_t k = 0; k < bodies.size(); ++k) {
+        uint32_t i = bodies[k];
+        glm::vec3 velocity(afterX[i] - beforeX[i], afterY[i] - beforeY[i], afterZ[i] - beforeZ[i]);
+        system.add(glm::vec3(orbits.x[i], orbits.y[i], orbits.z[i]), velocity * inverse, masses[k]);
+        system.sceneBody.push_back(i);
+    }
+}
+
+void writeNBodyToScene(const NBodySystem& system, Scene& scene, float blend) {
+    for (size_t k = 0; k < system.sceneBody.size(); ++k) {
+        uint32_t i = system.sceneBody[k];
+        scene.orbits.x[i] = system.previousX[k] + (system.x[k] - system.previousX[k]) * blend;
+        scene.orbits.y[i] = system.previousY[k] + (system.y[k] - system.previousY[k]) * blend;
+        scene.orbits.z[i] = system.previousZ[k] + (system.z[k] - system.previousZ[k]) * blend;
+    }
+}
+
+// a heavy body at the origin and a thin disk on circular orbits around it
+static void buildBenchmarkDisk(NBodySystem& system, size_t count) {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::normal_distribution<float> height(0.0f, 0.02f);
+    float centralMass = 1.0f;
+    float diskMass = 0.01f / std::max<size_t>(count - 1, 1);
+    system.add(glm::vec3(0.0f), glm::vec3(0.0f), centralMass);
+    for (size_t i = 1; i < count; ++i) {
+        float radius = 0.5f + 1.5f * unit(random);
+        float angle = glm::two_pi<float>() * unit(random);
+        float speed = std::sqrt(system.settings.gravity * centralMass / radius);
+        glm::vec3 position(radius * std::cos(angle), height(random), radius * std::sin(angle));
+        glm::vec3 velocity(-speed * std::sin(angle), 0.0f, speed * std::cos(angle));
+        system.add(position, velocity, diskMass);
+    }
+}
+
+void benchmarkNBody(const std::vector<size_t>& counts, const NBodySettings& settings) {
+    const size_t fullDirectLimit = 10000;  // above this the direct sum is timed on a sample
+    const size_t sampleSize = 1000;
+
+    std::cout << "N-body: opening angle " << settings.openingAngle << ", leaf size " << settings.leafSize << std::endl;
+    for (size_t count : counts) {
+        NBodySystem system;
+        system.settings = settings;
+        buildBenchmarkDisk(system, count);
+        computeAccelerations(system);
+
+        // as many steps as fit in a second, at least one
+        size_t steps = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed{0};
+        do {
+            stepNBody(system, 0.001f);
+            ++steps;
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed.count() < 1.0);
+        double treeStepsPerSecond = steps / elapsed.count();
+
+        auto buildStart = std::chrono::steady_clock::now();
+        buildOctree(system);
+        std::chrono::duration<double, std::milli> buildTime = std::chrono::steady_clock::now() - buildStart;
+
+        // the direct sum on every body, or on an evenly spread sample scaled up to all of them
+        size_t sampled = count <= fullDirectLimit ? count : sampleSize;
+        size_t stride = count / sampled;
+        double maxError = 0.0, sumError = 0.0;
+        std::chrono::duration<double> directTime{0};
+        for (size_t s = 0; s < sampled; ++s) {
+            size_t body = s * stride;
+            auto directStart = std::chrono::steady_clock::now();
+            glm::vec3 reference = directAcceleration(system, body);
+            directTime += std::chrono::steady_clock::now() - directStart;
+            glm::vec3 tree(system.ax[body], system.ay[body], system.az[body]);
+            double error = glm::length(tree - reference) / std::max(glm::length(reference), 1e-20f);
+            maxError = std::max(maxError, error);
+            sumError += error;
+        }
+        double directStepsPerSecond = sampled / (directTime.count() * count);
+
+        std::cout << "  " << count << " bodies: Barnes-Hut " << treeStepsPerSecond << " steps/s ("
+            << buildTime.count() << " ms tree build), direct " << directStepsPerSecond << " steps/s"
+            << (sampled < count ? " (sampled)" : "") << ", " << treeStepsPerSecond / directStepsPerSecond
+            << "x faster, acceleration error mean " << sumError / sampled << " max " << maxError << std::endl;
+    }
+}
@@ -0,0 +1,91 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: nbody.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "scene.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct NBodySettings {
+    float openingAngle = 0.5f;   // a cell is taken as one mass while width / distance is below this
+    float softening = 0.005f;    // keeps close encounters finite
+    float gravity = 1.0f;
+    size_t leafSize = 8;         // bodies summed one by one at the bottom of the tree
+};
+
+// cell of the octree, in depth-first order: its children follow it and skip is
+// the first node after its subtree, so walking the tree needs no stack
+struct OctreeNode {
+    float x, y, z;               // center of mass
+    float mass;
+    float width;
+    uint32_t first;              // range of the bodies in Morton order
+    uint32_t count;
+    uint32_t skip;
+    uint32_t leaf;
+};
+
+// levels of cells built before the rest; the cells below them are built as
+// jobs of their own, once there are enough bodies for that to pay
+constexpr int OCTREE_JOB_LEVEL = 2;
+constexpr size_t OCTREE_JOB_MIN = 16384;
+
+// what building the tree needs each step, kept between steps
+struct Octree {
+    std::vector<OctreeNode> nodes;
+    std::vector<uint64_t> codes;
+    std::vector<uint32_t> order;          // body index by Morton order
+    std::vector<uint64_t> codeScratch;
+    std::vector<uint32_t> orderScratch;
+    std::vector<float> x, y, z, mass;     // bodies in Morton order
+    std::vector<uint32_t> subtreeFirst, subtreeCount;   // cells at OCTREE_JOB_LEVEL
+    std::vector<std::vector<OctreeNode>> subtrees;      // their nodes, skips counted from their own start
+};
+
+// bodies moved by their mutual gravity, integrated with kick-drift-kick leapfrog
+struct NBodySystem {
+    std::vector<float> x, y, z;
+    std::vector<float> vx, vy, vz;
+    std::vector<float> ax, ay, az;        // at the current positions
+    std::vector<float> mass;
+    std::vector<float> previousX, previousY, previousZ;  // before the last step, to draw in between
+    std::vector<uint32_t> sceneBody;      // which scene body each one moves, when made from a scene
+    NBodySettings settings;
+    Octree tree;
+    bool accelerated = false;             // ax/ay/az match the positions
+
+    size_t size() const { return mass.size(); }
+    uint32_t add(const glm::vec3& position, const glm::vec3& velocity, float bodyMass);
+};
+
+// rebuilds the octree over the current positions, in parallel
+void buildOctree(NBodySystem& system);
+
+// Barnes-Hut accelerations of every body, building the tree first
+void computeAccelerations(NBodySystem& system);
+
+// O(n^2) acceleration of one body, summed in double, for checking the tree
+glm::vec3 directAcceleration(const NBodySystem& system, size_t body);
+
+// advances every body by dt; symplectic, so orbits don't drift in energy
+void stepNBody(NBodySystem& system, float dt);
+
+// one body for each of the given scene bodies, where the scene puts it at the
+// given time and moving like its orbit does there, with the mass given for it
+void nbodyFromScene(NBodySystem& system, Scene& scene, double time, const std::vector<uint32_t>& bodies, const std::vector<float>& masses);
+
+// hands the simulated positions to the scene bodies they came from, after any
+// solveOrbits for the rest and before placeBodies; blend goes from the positions
+// before the last step at 0 to the current ones at 1
+void writeNBodyToScene(const NBodySystem& system, Scene& scene, float blend = 1.0f);
+
+// steps per second at every count against the direct sum, whose cost and
+// error are measured on a sample of bodies for the large counts
+void benchmarkNBody(const std::vector<size_t>& counts, const NBodySettings& settings);
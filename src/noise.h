@@ -14,8 +14,8 @@ Last modification: 23/11/2023
 constexpr int NOISE_WIDTH = 512;
 constexpr int NOISE_HEIGHT = 512;
 
-FastNoiseLite noise;
+inline FastNoiseLite noise;
 
-void setupNoise() {
+inline void setupNoise() {
   noise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
 }
@@ -0,0 +1,226 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: orbit.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "orbit.h"
+#include "jobSystem.h"
+#include <cmath>
+#include <cassert>
+#include <iostream>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+// highest eccentricity the fixed number of Newton steps below converges for
+constexpr float MAX_ECCENTRICITY = 0.95f;
+
+// Newton steps from E = M + e sin M until the error is around float precision
+static int keplerIterations(float eccentricity) {
+    if (eccentricity < 0.1f) return 1;
+    if (eccentricity < 0.4f) return 2;
+    if (eccentricity < 0.7f) return 3;
+    if (eccentricity < 0.85f) return 4;
+    if (eccentricity < 0.92f) return 5;
+    return 6;
+}
+
+size_t Orbits::memoryBytes() const {
+    size_t floats = majorX.capacity() + majorY.capacity() + majorZ.capacity()
+        + minorX.capacity() + minorY.capacity() + minorZ.capacity()
+        + eccentricity.capacity() + meanAnomaly.capacity() + meanMotion.capacity()
+        + x.capacity() + y.capacity() + z.capacity();
+    return floats * sizeof(float) + (parent.capacity() + children.capacity()) * sizeof(uint32_t);
+}
+
+void Orbits::reserve(size_t count) {
+    for (std::vector<float>* field : {&majorX, &majorY, &majorZ, &minorX, &minorY, &minorZ, &eccentricity, &meanAnomaly, &meanMotion, &x, &y, &z}) {
+        field->reserve(count);
+    }
+    parent.reserve(count);
+}
+
+uint32_t Orbits::add(const KeplerOrbit& orbit) {
+    uint32_t index = static_cast<uint32_t>(size());
+    // the parent has to be solved first for the children pass to see its final position
+    assert(orbit.parent == ORBIT_NO_PARENT || orbit.parent < index);
+    uint32_t parentIndex = orbit.parent;
+    if (parentIndex != ORBIT_NO_PARENT && parentIndex >= index) {
+        std::cout << "Error: body " << index << " orbits body " << parentIndex << ", which isn't added yet; it orbits the origin instead." << std::endl;
+        parentIndex = ORBIT_NO_PARENT;
+    }
+
+    glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), glm::radians(orbit.ascendingNode), glm::vec3(0.0f, 1.0f, 0.0f));
+    rotation = glm::rotate(rotation, glm::radians(orbit.inclination), glm::vec3(1.0f, 0.0f, 0.0f));
+    rotation = glm::rotate(rotation, glm::radians(orbit.periapsisArgument), glm::vec3(0.0f, 1.0f, 0.0f));
+    float e = glm::clamp(orbit.eccentricity, 0.0f, MAX_ECCENTRICITY);
+    float a = orbit.semiMajorAxis;
+    float b = a * std::sqrt(1.0f - e * e);
+    glm::vec3 major = a * glm::vec3(rotation * glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
+    glm::vec3 minor = b * glm::vec3(rotation * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+
+    majorX.push_back(major.x);
+    majorY.push_back(major.y);
+    majorZ.push_back(major.z);
+    minorX.push_back(minor.x);
+    minorY.push_back(minor.y);
+    minorZ.push_back(minor.z);
+    eccentricity.push_back(e);
+    meanAnomaly.push_back(orbit.meanAnomaly / 360.0f);
+    meanMotion.push_back(orbit.meanMotion / 360.0f);
+    parent.push_back(parentIndex);
+    if (parentIndex != ORBIT_NO_PARENT) {
+        children.push_back(index);
+    }
+    iterations = std::max(iterations, keplerIterations(e));
+
+    x.push_back(0.0f);
+    y.push_back(0.0f);
+    z.push_back(0.0f);
+    return index;
+}
+
+static void solveOrbit(Orbits& orbits, size_t i, double time) {
+    // the mean anomaly is wrapped in double so late times don't lose the fraction
+    double turns = orbits.meanAnomaly[i] + static_cast<double>(orbits.meanMotion[i]) * time;
+    float meanAnomaly = static_cast<float>((turns - std::floor(turns + 0.5)) * 2.0 * glm::pi<double>());
+    float e = orbits.eccentricity[i];
+
+    float eccentricAnomaly = meanAnomaly + e * std::sin(meanAnomaly);
+    for (int step = 0; step < orbits.iterations; ++step) {
+        eccentricAnomaly -= (eccentricAnomaly - e * std::sin(eccentricAnomaly) - meanAnomaly) / (1.0f - e * std::cos(eccentricAnomaly));
+    }
+    float alongMajor = std::cos(eccentricAnomaly) - e;
+    float alongMinor = std::sin(eccentricAnomaly);
+    orbits.x[i] = orbits.majorX[i] * alongMajor + orbits.minorX[i] * alongMinor;
+    orbits.y[i] = orbits.majorY[i] * alongMajor + orbits.minorY[i] * alongMinor;
+    orbits.z[i] = orbits.majorZ[i] * alongMajor + orbits.minorZ[i] * alongMinor;
+}
+
+#if defined(__AVX__)
+
+static inline __m256 multiplyAdd(__m256 a, __m256 b, __m256 c) {
+#if defined(__FMA__)
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+// sine and cosine of 8 angles within a few turns of 0: reduced to a quarter
+// turn around 0, where the cephes polynomials are within an ulp or two
+static inline void sinCos8(__m256 angle, __m256& sine, __m256& cosine) {
+    __m256 quadrant = _mm256_round_ps(_mm256_mul_ps(angle, _mm256_set1_ps(2.0f / glm::pi<float>())), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    // pi / 2 split in two so the reduction stays exact
+    __m256 r = multiplyAdd(quadrant, _mm256_set1_ps(-1.5703125f), angle);
+    r = multiplyAdd(quadrant, _mm256_set1_ps(-4.837512969970703125e-4f), r);
+    r = multiplyAdd(quadrant, _mm256_set1_ps(-7.549789948768648e-8f), r);
+    __m256 r2 = _mm256_mul_ps(r, r);
+
+    __m256 s = multiplyAdd(r2, _mm256_set1_ps(-1.9515295891e-4f), _mm256_set1_ps(8.3321608736e-3f));
+    s = multiplyAdd(r2, s, _mm256_set1_ps(-1.6666654611e-1f));
+    s = multiplyAdd(_mm256_mul_ps(r2, r), s, r);
+    __m256 c = multiplyAdd(r2, _mm256_set1_ps(2.443315711809948e-5f), _mm256_set1_ps(-1.388731625493765e-3f));
+    c = multiplyAdd(r2, c, _mm256_set1_ps(4.166664568298827e-2f));
+    c = multiplyAdd(_mm256_mul_ps(r2, r2), c, multiplyAdd(r2, _mm256_set1_ps(-0.5f), _mm256_set1_ps(1.0f)));
+
+    // quadrants 1 and 3 swap sine and cosine, 2 and 3 negate the sine, 1 and 2 the cosine
+    __m256i q = _mm256_cvtps_epi32(quadrant);
+    __m256 swap = _mm256_castsi256_ps(_mm256_slli_epi32(q, 31));
+    __m256 sineSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(q, 1), 31));
+    __m256 cosineSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(_mm256_add_epi32(q, _mm256_set1_epi32(1)), 1), 31));
+    sine = _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sineSign);
+    cosine = _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), cosineSign);
+}
+
+// mean anomaly in radians within half a turn of 0, wrapped in double like solveOrbit does
+static inline __m256 meanAnomaly8(const float* meanAnomaly, const float* meanMotion, __m256d time) {
+    __m256 turnsAtZero = _mm256_loadu_ps(meanAnomaly);
+    __m256 motion = _mm256_loadu_ps(meanMotion);
+    __m256d low = _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(turnsAtZero)), _mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(motion)), time));
+    __m256d high = _mm256_add_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(turnsAtZero, 1)), _mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(motion, 1)), time));
+    low = _mm256_sub_pd(low, _mm256_round_pd(low, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    high = _mm256_sub_pd(high, _mm256_round_pd(high, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    __m256 turns = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(low)), _mm256_cvtpd_ps(high), 1);
+    return _mm256_mul_ps(turns, _mm256_set1_ps(glm::two_pi<float>()));
+}
+
+// two batches of 8 at once: every Newton step depends on the one before, so
+// the second batch fills the pipeline while the first waits on its sine
+constexpr size_t ORBIT_BATCHES = 2;
+
+static void solveOrbitsX16(Orbits& orbits, size_t first, __m256d time) {
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 meanAnomaly[ORBIT_BATCHES], e[ORBIT_BATCHES], eccentricAnomaly[ORBIT_BATCHES];
+    __m256 sine[ORBIT_BATCHES], cosine[ORBIT_BATCHES], step[ORBIT_BATCHES];
+    for (size_t b = 0; b < ORBIT_BATCHES; ++b) {
+        size_t i = first + 8 * b;
+        meanAnomaly[b] = meanAnomaly8(&orbits.meanAnomaly[i], &orbits.meanMotion[i], time);
+        e[b] = _mm256_loadu_ps(&orbits.eccentricity[i]);
+        sinCos8(meanAnomaly[b], sine[b], cosine[b]);
+        eccentricAnomaly[b] = multiplyAdd(e[b], sine[b], meanAnomaly[b]);
+    }
+    for (int iteration = 0; iteration < orbits.iterations; ++iteration) {
+        for (size_t b = 0; b < ORBIT_BATCHES; ++b) {
+            sinCos8(eccentricAnomaly[b], sine[b], cosine[b]);
+            __m256 error = _mm256_sub_ps(_mm256_sub_ps(eccentricAnomaly[b], _mm256_mul_ps(e[b], sine[b])), meanAnomaly[b]);
+            __m256 slope = _mm256_sub_ps(one, _mm256_mul_ps(e[b], cosine[b]));
+            step[b] = _mm256_div_ps(error, slope);
+            eccentricAnomaly[b] = _mm256_sub_ps(eccentricAnomaly[b], step[b]);
+        }
+    }
+
+    for (size_t b = 0; b < ORBIT_BATCHES; ++b) {
+        size_t i = first + 8 * b;
+        // the last step is small enough to rotate the sine and cosine to first order
+        __m256 finalSine = _mm256_sub_ps(sine[b], _mm256_mul_ps(cosine[b], step[b]));
+        __m256 alongMajor = _mm256_sub_ps(multiplyAdd(sine[b], step[b], cosine[b]), e[b]);
+        const float* majors[3] = {&orbits.majorX[i], &orbits.majorY[i], &orbits.majorZ[i]};
+        const float* minors[3] = {&orbits.minorX[i], &orbits.minorY[i], &orbits.minorZ[i]};
+        float* outputs[3] = {&orbits.x[i], &orbits.y[i], &orbits.z[i]};
+        for (int axis = 0; axis < 3; ++axis) {
+            __m256 position = multiplyAdd(_mm256_loadu_ps(majors[axis]), alongMajor, _mm256_mul_ps(_mm256_loadu_ps(minors[axis]), finalSine));
+            _mm256_storeu_ps(outputs[axis], position);
+        }
+    }
+}
+
+#endif
+
+// bodies per range handed to a thread at least
+constexpr size_t ORBIT_GRAIN = 4096;
+
+void solveOrbits(Orbits& orbits, double time) {
+    // every body is solved on its own, so ranges of them can go to any thread.
+    // ranges are split on whole batches, so the same bodies take the scalar
+    // path at any thread count and the result doesn't depend on it
+    size_t count = orbits.size();
+    const size_t width = 16;  // what the AVX path solves at once
+    parallelFor((count + width - 1) / width, ORBIT_GRAIN / width, [&](size_t firstBatch, size_t endBatch) {
+        size_t i = firstBatch * width;
+        size_t end = std::min(endBatch * width, count);
+#if defined(__AVX__)
+        __m256d time4 = _mm256_set1_pd(time);
+        for (; i + 8 * ORBIT_BATCHES <= end; i += 8 * ORBIT_BATCHES) {
+            solveOrbitsX16(orbits, i, time4);
+        }
+#endif
+        for (; i < end; ++i) {
+            solveOrbit(orbits, i, time);
+        }
+    });
+
+    for (uint32_t child : orbits.children) {
+        uint32_t parent = orbits.parent[child];
+        orbits.x[child] += orbits.x[parent];
+        orbits.y[child] += orbits.y[parent];
+        orbits.z[child] += orbits.z[parent];
+    }
+}
@@ -0,0 +1,54 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: orbit.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+constexpr uint32_t ORBIT_NO_PARENT = UINT32_MAX;
+
+// classical elements of an orbit; the reference plane is xz with y up, and with
+// every angle at 0 the body starts at +x and moves towards +z. angles in degrees,
+// time in the same unit the scene is animated with
+struct KeplerOrbit {
+    float semiMajorAxis = 0.0f;      // 0 = sits on its parent (or the origin)
+    float eccentricity = 0.0f;       // [0, 0.95]
+    float inclination = 0.0f;
+    float ascendingNode = 0.0f;
+    float periapsisArgument = 0.0f;
+    float meanAnomaly = 0.0f;        // at time 0
+    float meanMotion = 0.0f;         // degrees of mean anomaly per unit of time
+    uint32_t parent = ORBIT_NO_PARENT;  // the orbit is around this body, which has to be added before
+};
+
+// every orbit as structure of arrays, reduced to what solving it needs: the
+// position is major * (cos E - e) + minor * sin E for the eccentric anomaly E
+struct Orbits {
+    std::vector<float> majorX, majorY, majorZ;  // towards the periapsis, scaled by a
+    std::vector<float> minorX, minorY, minorZ;  // 90 degrees ahead in the plane, scaled by b
+    std::vector<float> eccentricity;
+    std::vector<float> meanAnomaly;             // turns at time 0
+    std::vector<float> meanMotion;              // turns per unit of time
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> children;             // bodies with a parent, parents always first
+    int iterations = 1;                         // Newton steps, enough for the largest eccentricity
+
+    std::vector<float> x, y, z;                 // written by solveOrbits, or by a simulation instead
+
+    size_t size() const { return parent.size(); }
+    size_t memoryBytes() const;
+    void reserve(size_t count);
+
+    uint32_t add(const KeplerOrbit& orbit);
+};
+
+// positions of every body at the given time, solved directly rather than
+// stepped, so any time costs the same; bodies with a parent end up relative to it
+void solveOrbits(Orbits& orbits, double time);
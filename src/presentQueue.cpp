@@ -0,0 +1,208 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: presentQueue.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "presentQueue.h"
+#include "framebuffer.h"
+#include "jobSystem.h"
+#include <iostream>
+#include <algorithm>
+
+static bool createRenderer(PresentQueue& queue) {
+    queue.renderer = SDL_CreateRenderer(queue.window, -1, SDL_RENDERER_ACCELERATED);
+    if (!queue.renderer) {
+        return false;
+    }
+    // made once, the frames only refill it
+    queue.texture = SDL_CreateTexture(queue.renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
+    queue.format = SDL_AllocFormat(SDL_PIXELFORMAT_ARGB8888);
+    return true;
+}
+
+static void destroyRenderer(PresentQueue& queue) {
+    if (queue.format) {
+        SDL_FreeFormat(queue.format);
+    }
+    if (queue.texture) {
+        SDL_DestroyTexture(queue.texture);
+    }
+    if (queue.renderer) {
+        SDL_DestroyRenderer(queue.renderer);
+    }
+    queue.format = nullptr;
+    queue.texture = nullptr;
+    queue.renderer = nullptr;
+}
+
+static void presentSlot(PresentQueue& queue, const PresentSlot& slot) {
+    void* texturePixels;
+    int pitch;
+    if (SDL_LockTexture(queue.texture, NULL, &texturePixels, &pitch) == 0) {
+        Uint32* texturePixels32 = static_cast<Uint32*>(texturePixels);
+        // rows are converted by separate jobs, each writes only its own
+        parallelFor(SCREEN_HEIGHT, 32, [&](size_t firstRow, size_t endRow) {
+            for (size_t y = firstRow; y < endRow; ++y) {
+                Uint32* row = texturePixels32 + y * (pitch / sizeof(Uint32));
+                for (size_t x = 0; x < SCREEN_WIDTH; ++x) {
+                    const Color& color = slot.colors[y * SCREEN_WIDTH + x];
+                    row[x] = SDL_MapRGBA(queue.format, color.r, color.g, color.b, color.a);
+                }
+            }
+        });
+        SDL_UnlockTexture(queue.texture);
+    }
+    SDL_Rect textureRect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    SDL_RenderCopy(queue.renderer, queue.texture, NULL, &textureRect);
+    SDL_RenderPresent(queue.renderer);
+}
+
+// the oldest frame in the given state, or nullptr
+static PresentSlot* oldestSlot(PresentQueue& queue, PresentSlotState state) {
+    PresentSlot* oldest = nullptr;
+    for (PresentSlot& slot : queue.slots) {
+        if (slot.state == state && (!oldest || slot.frame < oldest->frame)) {
+            oldest = &slot;
+        }
+    }
+    return oldest;
+}
+
+static void retireSlot(PresentSlot& slot) {
+    slot.state = PresentSlotState::Free;
+    slot.frame = 0;
+}
+
+static void presentFrames(PresentQueue& queue) {
+    bool created = createRenderer(queue);
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.started = true;
+    }
+    queue.changed.notify_all();
+    if (!created) {
+        return;
+    }
+    while (true) {
+        PresentSlot* slot = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.changed.wait(lock, [&] { return queue.stopping || oldestSlot(queue, PresentSlotState::Ready); });
+            // frames handed over before stopping are still presented, the last one included
+            slot = oldestSlot(queue, PresentSlotState::Ready);
+            if (!slot) {
+                break;
+            }
+            slot->state = PresentSlotState::Presenting;
+        }
+        presentSlot(queue, *slot);
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            retireSlot(*slot);
+            ++queue.stats.presented;
+        }
+        queue.changed.notify_all();
+    }
+    destroyRenderer(queue);
+}
+
+bool startPresentQueue(PresentQueue& queue, SDL_Window* window, size_t buffers, bool threaded) {
+    queue.window = window;
+    queue.threaded = threaded;
+    queue.started = false;
+    queue.stopping = false;
+    queue.stats = PresentStats();
+    queue.slots.assign(threaded ? std::max<size_t>(buffers, 2) : 1, PresentSlot());
+    for (PresentSlot& slot : queue.slots) {
+        slot.colors.resize(SCREEN_WIDTH * SCREEN_HEIGHT);
+    }
+    if (!threaded) {
+        return createRenderer(queue);
+    }
+
+    // the renderer is made on the presenting thread; wait to hear whether it could be
+    queue.presenter = std::thread(presentFrames, std::ref(queue));
+    bool created = false;
+    {
+        std::unique_lock<std::mutex> lock(queue.mutex);
+        queue.changed.wait(lock, [&] { return queue.started; });
+        created = queue.renderer != nullptr;
+    }
+    if (!created) {
+        queue.presenter.join();
+    }
+    return created;
+}
+
+PresentFence presentFramebuffer(PresentQueue& queue) {
+    PresentSlot* slot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        slot = oldestSlot(queue, PresentSlotState::Free);
+        if (!slot) {
+            // the display is behind: the oldest frame still waiting makes way.
+            // with at least two buffers one of them is waiting when none is free
+            slot = oldestSlot(queue, PresentSlotState::Ready);
+            retireSlot(*slot);
+            ++queue.stats.dropped;
+        }
+        slot->state = PresentSlotState::Writing;
+    }
+    resolveFramebuffer(slot->colors.data());
+
+    PresentFence fence;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        fence.frame = ++queue.stats.submitted;
+        slot->frame = fence.frame;
+        slot->state = PresentSlotState::Ready;
+    }
+    if (!queue.threaded) {
+        slot->state = PresentSlotState::Presenting;
+        presentSlot(queue, *slot);
+        retireSlot(*slot);
+        ++queue.stats.presented;
+        return fence;
+    }
+    queue.changed.notify_all();
+    return fence;
+}
+
+void waitForPresent(PresentQueue& queue, PresentFence fence) {
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    // done once no buffer holds it any more
+    queue.changed.wait(lock, [&] {
+        return queue.stopping || fence.frame == 0 || std::none_of(queue.slots.begin(), queue.slots.end(), [&](const PresentSlot& slot) {
+            return slot.frame == fence.frame && slot.state != PresentSlotState::Free;
+        });
+    });
+}
+
+PresentStats presentStats(PresentQueue& queue) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    return queue.stats;
+}
+
+void stopPresentQueue(PresentQueue& queue) {
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.stopping = true;
+    }
+    queue.changed.notify_all();
+    if (queue.presenter.joinable()) {
+        queue.presenter.join();
+    } else {
+        destroyRenderer(queue);
+    }
+    // only left when the renderer couldn't be made; they are lost, so they count
+    for (PresentSlot& slot : queue.slots) {
+        if (slot.state == PresentSlotState::Ready) {
+            retireSlot(slot);
+            ++queue.stats.dropped;
+        }
+    }
+}
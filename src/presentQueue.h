@@ -0,0 +1,75 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: presentQueue.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "colors.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <SDL2/SDL.h>
+
+// what a buffer of the ring is doing
+enum class PresentSlotState { Free, Writing, Ready, Presenting };
+
+// one finished frame's colors, rows top down
+struct PresentSlot {
+    std::vector<Color> colors;
+    PresentSlotState state = PresentSlotState::Free;
+    uint64_t frame = 0;  // while Ready or Presenting
+};
+
+// counted since the queue started
+struct PresentStats {
+    uint64_t submitted = 0;
+    uint64_t presented = 0;
+    uint64_t dropped = 0;  // replaced by a newer frame before the display got to them
+};
+
+// a frame handed to the queue; done once it was presented or dropped
+struct PresentFence {
+    uint64_t frame = 0;
+};
+
+// finished frames go into a ring of buffers, from which a thread of its own
+// converts, uploads and presents them, oldest first, while the next frames are
+// drawn. when the display falls behind and no buffer is free, the oldest frame
+// still waiting is dropped for the new one, so drawing never waits on it.
+// the presenting thread makes the renderer and is the only one using it
+struct PresentQueue {
+    SDL_Window* window = nullptr;
+    SDL_Renderer* renderer = nullptr;
+    SDL_Texture* texture = nullptr;
+    SDL_PixelFormat* format = nullptr;
+    bool threaded = true;  // false = converted and presented by the thread handing frames over
+
+    std::vector<PresentSlot> slots;
+    std::thread presenter;
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool started = false;  // the presenting thread tried to make the renderer
+    bool stopping = false;
+    PresentStats stats;
+};
+
+// 2 or 3 buffers; false when no renderer could be made for the window
+bool startPresentQueue(PresentQueue& queue, SDL_Window* window, size_t buffers, bool threaded);
+
+// hands the framebuffer's current image over; it can be drawn again right away
+PresentFence presentFramebuffer(PresentQueue& queue);
+
+// waits until the frame was presented or dropped
+void waitForPresent(PresentQueue& queue, PresentFence fence);
+
+PresentStats presentStats(PresentQueue& queue);
+
+// presents the frames still waiting, then stops; the renderer goes with the thread that made it
+void stopPresentQueue(PresentQueue& queue);
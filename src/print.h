@@ -13,25 +13,25 @@ Last modification: 23/11/2023
 #include <iostream>
 #include <glm/glm.hpp>
 
-void print(const Vertex& v) {
+inline void print(const Vertex& v) {
     std::cout << "Vertex{";
     std::cout << "(" << v.position.x << ", " << v.position.y << ", " << v.position.z << ")";
     std::cout << "}" << std::endl;
 }
 
-void print(const glm::ivec2& v) {
+inline void print(const glm::ivec2& v) {
     std::cout << "glm::vec2(" << v.x << ", " << v.y << ")" << std::endl;
 }
 
-void print(const glm::vec3& v) {
+inline void print(const glm::vec3& v) {
     std::cout << "glm::vec3(" << v.x << ", " << v.y << ", " << v.z << ")" << std::endl;
 }
 
-void print(const glm::vec4& v) {
+inline void print(const glm::vec4& v) {
     std::cout << "glm::vec4(" << v.x << ", " << v.y << ", " << v.z << ", " << v.w << ")" << std::endl;
 }
 
-void print(const Color& c) {
+inline void print(const Color& c) {
     std::cout << "Color("
         << static_cast<int>(c.r) 
         << ", "
@@ -42,7 +42,7 @@ void print(const Color& c) {
     << std::endl;
 }
 
-void print(const glm::mat4& m) {
+inline void print(const glm::mat4& m) {
     std::cout << "glm::mat4(\n";
     for(int i = 0; i < 4; ++i) {
         std::cout << "  ";
@@ -0,0 +1,253 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: renderer.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "renderer.h"
+#include "meshLod.h"
+#include "clipping.h"
+#include "analyticSphere.h"
+#include "triangles.h"
+#include "framebuffer.h"
+#include "jobSystem.h"
+#include <algorithm>
+
+// only the vertices of meshlets that survived culling are transformed
+static void vertexShaderStep(RenderContext& context, const VertexStreams& streams, const VertexStageConstants& constants) {
+    transformVertices(streams, context.meshletScratch.vertices, constants, context.transformedVertices);
+}
+
+static void primitiveAssemblyStep(RenderContext& context, const VertexStreams& streams, const glm::mat4& viewport) {
+    const TransformedVertices& transformed = context.transformedVertices;
+    Span<uint32_t> indices = context.meshletScratch.indices;
+
+    // texture coordinates are only streamed in when a texture is bound to read them
+    bool readTexCoords = currentTexture != nullptr && !streams.texCoords.empty();
+    auto assemble = [&](uint32_t index) {
+        return ClipVertex{
+            transformed.clip(index),
+            transformed.normal(index),
+            readTexCoords ? streams.texCoords[index] : glm::vec2(0.0f),
+            transformed.world(index),
+            streams.positions[index]
+        };
+    };
+
+    context.triangles.clear();
+    ClipVertex polygon[MAX_CLIPPED_VERTICES];
+    for (size_t i = 0; i < indices.size() / 3; ++i) {
+        ClipVertex triangle[3] = { assemble(indices[3 * i]), assemble(indices[3 * i + 1]), assemble(indices[3 * i + 2]) };
+        size_t count = clipTriangle(triangle, polygon);
+        if (count == 0) {
+            continue;
+        }
+        // the clipped polygon is convex, so a fan around its first vertex covers it
+        Vertex first = toScreen(polygon[0], viewport);
+        Vertex previous = toScreen(polygon[1], viewport);
+        for (size_t k = 2; k < count; ++k) {
+            Vertex current = toScreen(polygon[k], viewport);
+            context.triangles.push_back({ first, previous, current });
+            previous = current;
+        }
+    }
+}
+
+// triangles per raster job; fragments come out in triangle order however the
+// blocks are spread over threads
+constexpr size_t RASTER_BLOCK = 64;
+
+static void rasterizationStep(RenderContext& context) {
+    size_t width = context.target ? context.target->width : SCREEN_WIDTH;
+    size_t height = context.target ? context.target->height : SCREEN_HEIGHT;
+    const std::vector<std::array<Vertex, 3>>& triangles = context.triangles;
+    context.fragments.clear();
+    size_t blocks = (triangles.size() + RASTER_BLOCK - 1) / RASTER_BLOCK;
+    if (blocks < 2 || jobSystem().threadCount() == 1) {
+        for (const std::array<Vertex, 3>& assembled : triangles) {
+            triangle(assembled[0], assembled[1], assembled[2], context.fragments, width, height);
+        }
+        return;
+    }
+
+    if (context.fragmentBlocks.size() < blocks) {
+        context.fragmentBlocks.resize(blocks);
+    }
+    parallelFor(blocks, 1, [&](size_t begin, size_t end) {
+        for (size_t block = begin; block < end; ++block) {
+            std::vector<Fragment>& fragments = context.fragmentBlocks[block];
+            fragments.clear();
+            size_t last = std::min(triangles.size(), (block + 1) * RASTER_BLOCK);
+            for (size_t t = block * RASTER_BLOCK; t < last; ++t) {
+                triangle(triangles[t][0], triangles[t][1], triangles[t][2], fragments, width, height);
+            }
+        }
+    });
+    for (size_t block = 0; block < blocks; ++block) {
+        context.fragments.insert(context.fragments.end(), context.fragmentBlocks[block].begin(), context.fragmentBlocks[block].end());
+    }
+}
+
+void plot(RenderContext& context, const Fragment& fragment) {
+    if (!context.target) {
+        point(fragment);
+        return;
+    }
+    FragColor& pixel = context.target->pixels[fragment.y * context.target->width + fragment.x];
+    if (fragment.z < pixel.z) {
+        pixel = FragColor{fragment.color, fragment.z};
+    }
+}
+
+void shadeFragments(std::vector<Fragment>& fragments, shaderType shader) {
+    parallelFor(fragments.size(), 256, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            fragments[i] = fragmentShader(fragments[i], shader);
+        }
+    });
+}
+
+// early depth test: a fragment behind what is already drawn isn't worth shading,
+// so the nearer the earlier draws are the less gets shaded. the survivors are
+// shaded in parallel and written back in their order, so the image is the same
+// at any thread count
+static void fragmentShaderStep(RenderContext& context, shaderType shader) {
+    const FragColor* pixels = context.target ? context.target->pixels.data() : framebuffer.data();
+    size_t width = context.target ? context.target->width : SCREEN_WIDTH;
+    context.shaded.clear();
+    for (const Fragment& fragment : context.fragments) {
+        if (fragment.z < pixels[fragment.y * width + fragment.x].z) {
+            context.shaded.push_back(fragment);
+        }
+    }
+    shadeFragments(context.shaded, shader);
+    for (const Fragment& fragment : context.shaded) {
+        plot(context, fragment);
+    }
+    context.stats.shadedFragments += context.shaded.size();
+}
+
+void drawInstanced(RenderContext& context, const MeshView& mesh, Span<Instance> instances, const Uniforms& frame) {
+    glm::mat4 clipFromWorld = frame.projection * frame.view;
+    glm::vec3 eye = glm::vec3(glm::inverse(frame.view) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    Uniforms uniforms = frame;
+
+    for (const Instance& instance : instances) {
+        uniforms.model = instance.model;
+        MeshView level = mesh.lod(selectLod(mesh, projectedRadius(mesh, uniforms)));
+        MeshletCullStats culled = cullMeshlets(level, prepareMeshletCulling(clipFromWorld, eye, instance.model), context.meshletScratch);
+        context.stats.visibleMeshlets += culled.visible;
+        context.stats.culledMeshlets += culled.backfacing + culled.outside;
+        if (context.meshletScratch.indices.empty()) {
+            ++context.stats.culledInstances;
+            continue;
+        }
+        ++context.stats.drawnInstances;
+        vertexShaderStep(context, level.streams, prepareVertexStage(clipFromWorld, instance.model));
+        primitiveAssemblyStep(context, level.streams, frame.viewport);
+        rasterizationStep(context);
+        fragmentShaderStep(context, instance.shader);
+        context.stats.triangles += context.triangles.size();
+        context.stats.fragments += context.fragments.size();
+    }
+}
+
+// world positions and normals of the vertices the last cull listed that no
+// earlier view of this instance needed; the rest only get the view's clip positions
+static void sharedVertexShaderStep(RenderContext& context, const VertexStreams& streams, const glm::mat4& clipFromWorld, const glm::mat4& model) {
+    context.newVertices.clear();
+    context.seenVertices.clear();
+    for (uint32_t vertex : context.meshletScratch.vertices) {
+        if (context.transformedIn[vertex] == context.instance) {
+            context.seenVertices.push_back(vertex);
+        } else {
+            context.transformedIn[vertex] = context.instance;
+            context.newVertices.push_back(vertex);
+        }
+    }
+    transformVertices(streams, context.newVertices, prepareVertexStage(clipFromWorld, model), context.transformedVertices);
+    projectToClip(context.seenVertices, clipFromWorld, context.transformedVertices);
+    context.stats.projectedVertices += context.seenVertices.size();
+}
+
+void drawInstancedViews(RenderContext& context, const MeshView& mesh, Span<Instance> instances, Span<uint8_t> viewMasks, Span<RenderView> views) {
+    size_t viewCount = std::min(views.size(), MAX_VIEWS);
+    glm::mat4 clipFromWorld[MAX_VIEWS];
+    glm::vec3 eye[MAX_VIEWS];
+    for (size_t v = 0; v < viewCount; ++v) {
+        clipFromWorld[v] = views[v].frame.projection * views[v].frame.view;
+        eye[v] = glm::vec3(glm::inverse(views[v].frame.view)[3]);
+    }
+    RenderTarget* target = context.target;
+
+    for (size_t i = 0; i < instances.size(); ++i) {
+        const Instance& instance = instances[i];
+        uint8_t mask = viewMasks[i];
+        if (mask == 0) {
+            continue;
+        }
+
+        // the view the instance is largest in decides the level for all of them
+        float radius = 0.0f;
+        for (size_t v = 0; v < viewCount; ++v) {
+            if (mask & (1u << v)) {
+                Uniforms uniforms = views[v].frame;
+                uniforms.model = instance.model;
+                radius = std::max(radius, projectedRadius(mesh, uniforms));
+            }
+        }
+        MeshView level = mesh.lod(selectLod(mesh, radius));
+        if (context.transformedIn.size() < level.streams.size()) {
+            context.transformedIn.resize(level.streams.size(), 0);
+        }
+        if (++context.instance == 0) {
+            std::fill(context.transformedIn.begin(), context.transformedIn.end(), 0);
+            context.instance = 1;
+        }
+
+        for (size_t v = 0; v < viewCount; ++v) {
+            if (!(mask & (1u << v))) {
+                continue;
+            }
+            MeshletCullStats culled = cullMeshlets(level, prepareMeshletCulling(clipFromWorld[v], eye[v], instance.model), context.meshletScratch);
+            context.stats.visibleMeshlets += culled.visible;
+            context.stats.culledMeshlets += culled.backfacing + culled.outside;
+            if (context.meshletScratch.indices.empty()) {
+                ++context.stats.culledInstances;
+                continue;
+            }
+            ++context.stats.drawnInstances;
+            context.target = views[v].target;
+            sharedVertexShaderStep(context, level.streams, clipFromWorld[v], instance.model);
+            primitiveAssemblyStep(context, level.streams, views[v].frame.viewport);
+            rasterizationStep(context);
+            fragmentShaderStep(context, instance.shader);
+            context.stats.triangles += context.triangles.size();
+            context.stats.fragments += context.fragments.size();
+        }
+    }
+    context.target = target;
+}
+
+void drawSpheres(RenderContext& context, const MeshView& mesh, Span<Instance> instances, const Uniforms& frame) {
+    SphereCamera camera = prepareSphereCamera(frame);
+    for (const Instance& instance : instances) {
+        context.fragments.clear();
+        sphereFragments(camera, instance.model, mesh.boundsCenter, mesh.boundsRadius, context.fragments);
+        if (context.fragments.empty()) {
+            ++context.stats.culledInstances;
+            continue;
+        }
+        ++context.stats.drawnInstances;
+        fragmentShaderStep(context, instance.shader);
+        context.stats.fragments += context.fragments.size();
+    }
+}
+
+void render(RenderContext& context, const MeshView& mesh, const Uniforms& uniforms, shaderType shader) {
+    Instance instance{uniforms.model, shader, 0};
+    drawInstanced(context, mesh, Span<Instance>(&instance, 1), uniforms);
+}
@@ -0,0 +1,94 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: renderer.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "mesh.h"
+#include "fragment.h"
+#include "shaders.h"
+#include "meshlet.h"
+#include "vertexStage.h"
+#include "framebuffer.h"
+#include <array>
+#include <vector>
+#include <glm/glm.hpp>
+
+// what changes from one copy of a mesh to the next
+struct Instance {
+    glm::mat4 model;
+    shaderType shader;
+    uint32_t id;  // stable from frame to frame, keys what is cached per body
+};
+
+// counters accumulated by every draw until the caller resets them
+struct RenderStats {
+    size_t drawnInstances = 0;
+    size_t culledInstances = 0;  // no meshlet survived culling
+    size_t visibleMeshlets = 0;
+    size_t culledMeshlets = 0;
+    size_t triangles = 0;        // after clipping
+    size_t fragments = 0;
+    size_t shadedFragments = 0;  // passed the early depth test
+    size_t coveredPixels = 0;    // added by the caller per finished frame, shaded / covered is the overdraw
+    size_t outsideBodies = 0;    // bounding sphere out of the frustum, never drawn
+    size_t occludedBodies = 0;   // behind a nearer body, never drawn
+    size_t impostors = 0;        // instances drawn as a sprite from the atlas
+    size_t impostorRefreshes = 0;
+    size_t projectedVertices = 0;  // reused by another view of the same instance, only projected again
+};
+
+// buffers every stage writes into; they are kept between draws and frames
+// so drawing in steady state doesn't allocate
+struct RenderContext {
+    TransformedVertices transformedVertices;
+    MeshletScratch meshletScratch;
+    std::vector<std::array<Vertex, 3>> triangles;
+    std::vector<Fragment> fragments;
+    std::vector<std::vector<Fragment>> fragmentBlocks;  // rasterized by separate jobs, joined in triangle order
+    std::vector<Fragment> shaded;
+    RenderStats stats;
+    RenderTarget* target = nullptr;  // drawn into, nullptr = the framebuffer
+
+    // which vertices one instance already transformed for an earlier view
+    std::vector<uint32_t> transformedIn;
+    uint32_t instance = 0;
+    std::vector<uint32_t> newVertices;
+    std::vector<uint32_t> seenVertices;
+};
+
+// views a multi-view draw can have, one bit of a view mask each
+constexpr size_t MAX_VIEWS = 8;
+
+// one camera of a multi-view draw; its viewport has to match the target's size
+struct RenderView {
+    Uniforms frame;
+    RenderTarget* target = nullptr;  // nullptr = the framebuffer
+};
+
+// writes the fragment to the context's target where it is nearer than what is there
+void plot(RenderContext& context, const Fragment& fragment);
+
+// runs the shader on every fragment in place, ranges of them on the job system
+void shadeFragments(std::vector<Fragment>& fragments, shaderType shader);
+
+// draws the mesh once per instance; view, projection and viewport come from
+// frame and are set up once for all of them, frame.model is ignored
+void drawInstanced(RenderContext& context, const MeshView& mesh, Span<Instance> instances, const Uniforms& frame);
+
+// draws the instances into several views at once; bit v of viewMasks[i] says
+// whether instance i is seen by views[v]. the level of detail is picked once for
+// the view it is largest in, and world positions and normals are transformed once
+// per instance, so a view after the first only culls, projects and rasterizes
+void drawInstancedViews(RenderContext& context, const MeshView& mesh, Span<Instance> instances, Span<uint8_t> viewMasks, Span<RenderView> views);
+
+// same as drawInstanced for meshes that are spheres: each instance is ray cast
+// against the mesh's bounding sphere over its bounding square on screen, so the
+// cost follows the covered pixels and not the triangle count
+void drawSpheres(RenderContext& context, const MeshView& mesh, Span<Instance> instances, const Uniforms& frame);
+
+void render(RenderContext& context, const MeshView& mesh, const Uniforms& uniforms, shaderType shader);
@@ -0,0 +1,155 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: scene.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "scene.h"
+#include "jobSystem.h"
+#include <cmath>
+#include <algorithm>
+#include <random>
+
+// whether the ray from origin along direction crosses the triangle
+static bool rayCrosses(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    glm::vec3 ab = b - a;
+    glm::vec3 ac = c - a;
+    glm::vec3 p = glm::cross(direction, ac);
+    float determinant = glm::dot(ab, p);
+    if (std::abs(determinant) < 1e-12f) {
+        return false;
+    }
+    glm::vec3 toOrigin = origin - a;
+    float u = glm::dot(toOrigin, p) / determinant;
+    glm::vec3 q = glm::cross(toOrigin, ab);
+    float v = glm::dot(direction, q) / determinant;
+    return u >= 0.0f && v >= 0.0f && u + v <= 1.0f && glm::dot(ac, q) / determinant > 0.0f;
+}
+
+// nearest any triangle's plane comes to the center, which is a ball inside the
+// level when the center is enclosed by it: every face has to face away from the
+// center, all wound the same way, and a ray from it has to leave through an odd
+// number of faces. anything else (a torus, an open shell) gets 0 and hides nothing
+static float innerRadius(const MeshView& level) {
+    float radius = level.boundsRadius;
+    const Span<glm::vec3>& positions = level.streams.positions;
+    // a direction unlikely to run along an edge
+    const glm::vec3 direction = glm::normalize(glm::vec3(0.5773f, 0.6412f, 0.5057f));
+    size_t crossings = 0;
+    int facing = 0;
+    for (size_t i = 0; i + 2 < level.indices.size(); i += 3) {
+        glm::vec3 a = positions[level.indices[i]];
+        glm::vec3 b = positions[level.indices[i + 1]];
+        glm::vec3 c = positions[level.indices[i + 2]];
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        if (length == 0.0f) {
+            continue;
+        }
+        float away = glm::dot(normal, a - level.boundsCenter);
+        int side = away > 0.0f ? 1 : -1;
+        if (away == 0.0f || (facing != 0 && side != facing)) {
+            return 0.0f;
+        }
+        facing = side;
+        radius = std::min(radius, std::abs(away) / length);
+        crossings += rayCrosses(level.boundsCenter, direction, a, b, c) ? 1 : 0;
+    }
+    return crossings % 2 == 1 ? radius : 0.0f;
+}
+
+uint32_t Scene::addMesh(const MeshView& view) {
+    meshes.push_back(view);
+    std::vector<float> levels;
+    for (size_t level = 0; level < view.lodCount(); ++level) {
+        levels.push_back(innerRadius(view.lod(level)));
+    }
+    meshInnerRadius.push_back(levels);
+    return static_cast<uint32_t>(meshes.size() - 1);
+}
+
+uint32_t Scene::addBody(const BodyDescription& body) {
+    mesh.push_back(body.mesh);
+    shader.push_back(body.shader);
+    scale.push_back(body.scale);
+    orbits.add(body.orbit);
+    spinSpeed.push_back(body.spinSpeed);
+    visible.push_back(body.visible ? 1 : 0);
+    model.push_back(glm::mat4(1.0f));
+    return static_cast<uint32_t>(mesh.size() - 1);
+}
+
+void updateScene(Scene& scene, double time) {
+    solveOrbits(scene.orbits, time);
+    placeBodies(scene, time);
+}
+
+void placeBodies(Scene& scene, double time) {
+    const Orbits& orbits = scene.orbits;
+    parallelFor(scene.size(), 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            // wrapped like the mean anomaly, so late times keep the spin smooth
+            double turns = time * scene.spinSpeed[i] / 360.0;
+            float spin = static_cast<float>((turns - std::floor(turns)) * glm::two_pi<double>());
+            float s = scene.scale[i];
+            float cosSpin = std::cos(spin);
+            float sinSpin = std::sin(spin);
+
+            // translate(orbit position) * rotate(spin, y) * scale(s), written out
+            glm::mat4& model = scene.model[i];
+            model[0] = glm::vec4(cosSpin * s, 0.0f, -sinSpin * s, 0.0f);
+            model[1] = glm::vec4(0.0f, s, 0.0f, 0.0f);
+            model[2] = glm::vec4(sinSpin * s, 0.0f, cosSpin * s, 0.0f);
+            model[3] = glm::vec4(orbits.x[i], orbits.y[i], orbits.z[i], 1.0f);
+        }
+    });
+}
+
+size_t Scene::memoryBytes() const {
+    return meshes.capacity() * sizeof(MeshView)
+        + mesh.capacity() * sizeof(uint32_t)
+        + shader.capacity() * sizeof(shaderType)
+        + (scale.capacity() + spinSpeed.capacity()) * sizeof(float)
+        + orbits.memoryBytes()
+        + visible.capacity() * sizeof(uint8_t)
+        + model.capacity() * sizeof(glm::mat4);
+}
+
+void addAsteroidBelt(Scene& scene, uint32_t mesh, size_t count, const BeltSettings& settings) {
+    const shaderType rocky[] = {shaderType::Moon, shaderType::Pluton, shaderType::Random};
+    std::mt19937 random(settings.seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::normal_distribution<float> height(0.0f, settings.thickness * 0.5f);
+
+    for (std::vector<float>* field : {&scene.scale, &scene.spinSpeed}) {
+        field->reserve(field->size() + count);
+    }
+    scene.orbits.reserve(scene.orbits.size() + count);
+    scene.mesh.reserve(scene.mesh.size() + count);
+    scene.shader.reserve(scene.shader.size() + count);
+    scene.visible.reserve(scene.visible.size() + count);
+    scene.model.reserve(scene.model.size() + count);
+
+    for (size_t i = 0; i < count; ++i) {
+        BodyDescription body;
+        body.mesh = mesh;
+        body.shader = rocky[i % 3];
+        body.scale = settings.minScale + (settings.maxScale - settings.minScale) * unit(random) * unit(random);
+        // uniform over the ring's area, with Kepler's third law for the speed
+        float r2 = settings.innerRadius * settings.innerRadius
+            + (settings.outerRadius * settings.outerRadius - settings.innerRadius * settings.innerRadius) * unit(random);
+        KeplerOrbit& orbit = body.orbit;
+        orbit.semiMajorAxis = std::sqrt(r2);
+        orbit.meanMotion = std::pow(settings.innerRadius / orbit.semiMajorAxis, 1.5f);
+        orbit.meanAnomaly = 360.0f * unit(random);
+        orbit.eccentricity = settings.maxEccentricity * unit(random);
+        orbit.periapsisArgument = 360.0f * unit(random);
+        orbit.ascendingNode = 360.0f * unit(random);
+        orbit.inclination = glm::degrees(std::atan(std::abs(height(random)) / orbit.semiMajorAxis));
+        body.spinSpeed = 4.0f * unit(random) - 2.0f;
+        scene.addBody(body);
+    }
+}
@@ -0,0 +1,68 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: scene.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "mesh.h"
+#include "shaders.h"
+#include "orbit.h"
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// how a body is added; the scene itself keeps every field in its own array
+struct BodyDescription {
+    uint32_t mesh = 0;           // index into Scene::meshes
+    shaderType shader = shaderType::Earth;
+    float scale = 1.0f;
+    KeplerOrbit orbit;           // parent is a body index
+    float spinSpeed = 1.0f;      // spin degrees around y per unit of time
+    bool visible = true;
+};
+
+// bodies stored as structure of arrays, one entry per body in each array, so
+// the per-frame walk only streams the fields it reads
+struct Scene {
+    std::vector<MeshView> meshes;
+    std::vector<std::vector<float>> meshInnerRadius;  // ball around boundsCenter inside the mesh, by mesh and level; 0 unless the mesh encloses it
+
+    std::vector<uint32_t> mesh;
+    std::vector<shaderType> shader;
+    std::vector<float> scale;
+    Orbits orbits;
+    std::vector<float> spinSpeed;
+    std::vector<uint8_t> visible;
+    std::vector<glm::mat4> model;  // written by updateScene
+
+    size_t size() const { return mesh.size(); }
+    size_t memoryBytes() const;
+
+    uint32_t addMesh(const MeshView& view);
+    uint32_t addBody(const BodyDescription& body);
+};
+
+// places every body at the given time, which is the animation angle in degrees;
+// main's clock adds one per step, and any time can be jumped to directly
+void updateScene(Scene& scene, double time);
+
+// model matrices from the positions in scene.orbits as they are, spun for the given time
+void placeBodies(Scene& scene, double time);
+
+struct BeltSettings {
+    float innerRadius = 0.9f;
+    float outerRadius = 1.5f;
+    float thickness = 0.08f;     // spread of the heights the orbits reach
+    float maxEccentricity = 0.05f;
+    float minScale = 0.01f;
+    float maxScale = 0.04f;
+    uint32_t seed = 1;
+};
+
+// count small bodies on slightly eccentric and inclined orbits around the
+// origin, further out ones slower, each drawn with one of the rocky shaders
+void addAsteroidBelt(Scene& scene, uint32_t mesh, size_t count, const BeltSettings& settings = BeltSettings());
@@ -24,7 +24,7 @@ enum class shaderType {
     Venus
 };
 
-Vertex vertexShader(const Vertex& vertex, const Uniforms& uniforms) {
+inline Vertex vertexShader(const Vertex& vertex, const Uniforms& uniforms) {
     glm::vec4 clipSpaceVertex = uniforms.projection * uniforms.view * uniforms.model * glm::vec4(vertex.position, 1.0f);
     glm::vec3 ndcVertex = glm::vec3(clipSpaceVertex) / clipSpaceVertex.w;
     glm::vec4 screenVertex = uniforms.viewport * glm::vec4(ndcVertex, 1.0f);
@@ -43,7 +43,7 @@ Vertex vertexShader(const Vertex& vertex, const Uniforms& uniforms) {
     };
 }
 
-Color interpolateColor(const Color& color1, const Color& color2, float t) {
+inline Color interpolateColor(const Color& color1, const Color& color2, float t) {
     t = glm::clamp(t, 0.0f, 1.0f);
     return Color(
         static_cast<int>((1.0f - t) * color1.r + t * color2.r),
@@ -52,7 +52,7 @@ Color interpolateColor(const Color& color1, const Color& color2, float t) {
     );
 }
 
-float noiseGenerator(float x, float y, float z) {
+inline float noiseGenerator(float x, float y, float z) {
     FastNoiseLite noise;
     int offsetX = 1000;
     int offsetY = 1000;
@@ -68,7 +68,7 @@ float noiseGenerator(float x, float y, float z) {
     return (normalizedValue < LandThreshold) ? 1.0f : 0.0f;
 }
 
-float densityGenerator(float x, float y, float z) {
+inline float densityGenerator(float x, float y, float z) {
     FastNoiseLite noise;
     noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
     noise.SetFrequency(0.1f);
@@ -87,7 +87,7 @@ float densityGenerator(float x, float y, float z) {
     }
 }
 
-Fragment fragmentShaderMoon(Fragment& fragment) {
+inline Fragment fragmentShaderMoon(Fragment& fragment) {
     glm::vec3 sunCenter = glm::vec3(0.0f, 0.0f, 0.0f);
 
     glm::vec3 fragmentToMoon = sunCenter - fragment.worldPos;
@@ -111,7 +111,7 @@ Fragment fragmentShaderMoon(Fragment& fragment) {
     return fragment;
 }
 
-Fragment fragmentShaderEarth(Fragment& fragment) {
+inline Fragment fragmentShaderEarth(Fragment& fragment) {
     Color SouthPole;
     Color Land;
     Color Ocean;
@@ -151,7 +151,7 @@ Fragment fragmentShaderEarth(Fragment& fragment) {
     return fragment;
 }
 
-Fragment fragmentShaderNeptune(Fragment& fragment) {
+inline Fragment fragmentShaderNeptune(Fragment& fragment) {
     glm::vec3 hotColor = glm::vec3(0.172549f, 0.219608f, 0.541176f);
     glm::vec3 warmColor = glm::vec3(0.392157f, 0.478431f, 0.988235f);
     glm::vec3 coolColor = glm::vec3(0.0f, 1.0f, 1.0f);
@@ -173,7 +173,7 @@ Fragment fragmentShaderNeptune(Fragment& fragment) {
     return fragment;
 }
 
-Fragment fragmentShaderVenus(Fragment& fragment) {
+inline Fragment fragmentShaderVenus(Fragment& fragment) {
     glm::vec3 hotColor = glm::vec3(1.0, 0.18039215686, 0.4);
     glm::vec3 warmColor = glm::vec3(0.29019607843, 1.0, 0.50588235294);
     glm::vec3 coolColor = glm::vec3(0.9333, 0.5216, 0.4588);
@@ -215,7 +215,7 @@ Fragment fragmentShaderVenus(Fragment& fragment) {
 }
 
 
-Fragment fragmentShaderSun(Fragment& fragment) {
+inline Fragment fragmentShaderSun(Fragment& fragment) {
     glm::vec3 hotColor = glm::vec3(1.0, 0.498, 0.208);
     glm::vec3 warmColor = glm::vec3(1.0f, 0.0f, 0.0f);
 
@@ -229,7 +229,7 @@ Fragment fragmentShaderSun(Fragment& fragment) {
     return fragment;
 }
 
-Fragment fragmentShaderRandom(Fragment& fragment) {
+inline Fragment fragmentShaderRandom(Fragment& fragment) {
     glm::vec3 hotColor = glm::vec3(0.549, 0.286, 1.0);
     glm::vec3 warmColor = glm::vec3(0.549, 0.796, 0.047);
     glm::vec3 coolColor = glm::vec3(0.549, 0.796, 0.047);
@@ -262,7 +262,7 @@ Fragment fragmentShaderRandom(Fragment& fragment) {
     return fragment;
 }
 
-Fragment fragmentShaderPluton(Fragment& fragment) {
+inline Fragment fragmentShaderPluton(Fragment& fragment) {
     glm::vec3 sunCenter = glm::vec3(0.0f, 0.0f, 0.0f);
 
     glm::vec3 fragmentToMoon = sunCenter - fragment.worldPos;
@@ -286,7 +286,7 @@ Fragment fragmentShaderPluton(Fragment& fragment) {
     return fragment;
 }
 
-Fragment fragmentShader(Fragment& fragment, shaderType shaderType) {
+inline Fragment fragmentShader(Fragment& fragment, shaderType shaderType) {
     switch (shaderType) {
         case shaderType::Random:
             return fragmentShaderRandom(fragment);
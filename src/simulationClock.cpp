@@ -0,0 +1,35 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: simulationClock.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "simulationClock.h"
+#include <cmath>
+#include <algorithm>
+
+size_t advanceClock(SimulationClock& clock, double elapsedSeconds) {
+    size_t steps = clock.fixedSteps;
+    if (steps == 0) {
+        clock.pending += std::max(elapsedSeconds, 0.0) * clock.stepsPerSecond;
+        double due = std::floor(clock.pending);
+        clock.pending -= due;
+        steps = static_cast<size_t>(std::min(due, static_cast<double>(clock.maxStepsPerFrame)));
+        // a long stall would otherwise take longer to catch up on than it lasted
+        clock.droppedSteps += static_cast<uint64_t>(due) - steps;
+    }
+    clock.steps += steps;
+    clock.time += steps * clock.step;
+    return steps;
+}
+
+double interpolationAlpha(const SimulationClock& clock) {
+    return clock.fixedSteps > 0 ? 1.0 : clock.pending;
+}
+
+double renderTime(const SimulationClock& clock) {
+    return clock.time - (1.0 - interpolationAlpha(clock)) * clock.step;
+}
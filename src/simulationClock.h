@@ -0,0 +1,37 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: simulationClock.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// scene time advanced in fixed steps, however long frames take; frames are drawn
+// between the last two steps, so motion is smooth at any frame rate
+struct SimulationClock {
+    double step = 1.0;              // scene time per step, the animation degrees a frame used to add
+    double stepsPerSecond = 60.0;
+    size_t maxStepsPerFrame = 8;    // behind by more than this, the rest is dropped instead of caught up
+    size_t fixedSteps = 0;          // deterministic: exactly this many steps per frame, real time ignored; 0 = off
+
+    double time = 0.0;              // scene time after the last step
+    double pending = 0.0;           // the fraction of a step that is due but not run yet
+    uint64_t steps = 0;
+    uint64_t droppedSteps = 0;
+};
+
+// turns the real seconds the last frame took into steps and returns how many;
+// the caller runs that many fixed updates, time already counts them
+size_t advanceClock(SimulationClock& clock, double elapsedSeconds);
+
+// how far between the last two steps frames are drawn, 0 at the one before the
+// last and 1 at the last; always 1 when deterministic, so frames land on steps
+double interpolationAlpha(const SimulationClock& clock);
+
+// the scene time that alpha stands for, for what is solved directly in time
+double renderTime(const SimulationClock& clock);
@@ -0,0 +1,249 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: sphereGenerator.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "sphereGenerator.h"
+#include "meshLod.h"
+#include "meshOptimize.h"
+#include "meshlet.h"
+#include <map>
+#include <array>
+#include <cmath>
+#include <mutex>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+static void addVertex(MeshData& mesh, const glm::vec3& direction, const glm::vec2& uv) {
+    mesh.positions.push_back(direction * GENERATED_SPHERE_RADIUS);
+    mesh.normals.push_back(direction);
+    mesh.texCoords.push_back(uv);
+}
+
+static void addQuad(MeshData& mesh, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    mesh.indices.insert(mesh.indices.end(), {a, b, c, a, c, d});
+}
+
+// longitude from atan2 and latitude from asin, so u runs once around the equator
+static glm::vec2 sphericalUV(const glm::vec3& direction) {
+    float u = 0.5f + std::atan2(direction.z, direction.x) / glm::two_pi<float>();
+    float v = 0.5f + std::asin(glm::clamp(direction.y, -1.0f, 1.0f)) / glm::pi<float>();
+    return glm::vec2(u, v);
+}
+
+static void generateUVSphere(MeshData& mesh, int subdivisions) {
+    uint32_t segments = 8u << subdivisions;
+    uint32_t rings = 4u << subdivisions;
+
+    // one column more than segments so the seam gets its own u = 1 vertices
+    for (uint32_t ring = 0; ring <= rings; ++ring) {
+        float v = static_cast<float>(ring) / rings;
+        float latitude = glm::pi<float>() * (v - 0.5f);
+        for (uint32_t segment = 0; segment <= segments; ++segment) {
+            float u = static_cast<float>(segment) / segments;
+            // the poles get one vertex per segment, centered on it, so no UV is shared across a fan
+            if (ring == 0 || ring == rings) {
+                u = (segment + 0.5f) / segments;
+            }
+            float longitude = glm::two_pi<float>() * u;
+            glm::vec3 direction(
+                std::cos(latitude) * std::cos(longitude),
+                std::sin(latitude),
+                std::cos(latitude) * std::sin(longitude)
+            );
+            addVertex(mesh, direction, glm::vec2(u, v));
+        }
+    }
+
+    uint32_t stride = segments + 1;
+    for (uint32_t ring = 0; ring < rings; ++ring) {
+        for (uint32_t segment = 0; segment < segments; ++segment) {
+            uint32_t a = ring * stride + segment;
+            uint32_t b = a + 1;
+            uint32_t c = a + stride + 1;
+            uint32_t d = a + stride;
+            // counter-clockwise seen from outside
+            if (ring == 0) {
+                mesh.indices.insert(mesh.indices.end(), {a, d, c});
+            } else if (ring == rings - 1) {
+                mesh.indices.insert(mesh.indices.end(), {a, d, b});
+            } else {
+                addQuad(mesh, a, d, c, b);
+            }
+        }
+    }
+}
+
+static void generateIcoSphere(MeshData& mesh, int subdivisions) {
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    std::vector<glm::vec3> points = {
+        {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+        {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+        {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}
+    };
+    for (glm::vec3& point : points) {
+        point = glm::normalize(point);
+    }
+    std::vector<std::array<uint32_t, 3>> triangles = {
+        {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+        {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+        {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+        {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}
+    };
+
+    for (int level = 0; level < subdivisions; ++level) {
+        std::unordered_map<uint64_t, uint32_t> midpoints;
+        auto midpoint = [&](uint32_t a, uint32_t b) {
+            uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+            auto found = midpoints.find(key);
+            if (found != midpoints.end()) {
+                return found->second;
+            }
+            points.push_back(glm::normalize(points[a] + points[b]));
+            uint32_t index = static_cast<uint32_t>(points.size() - 1);
+            midpoints.emplace(key, index);
+            return index;
+        };
+
+        std::vector<std::array<uint32_t, 3>> refined;
+        refined.reserve(triangles.size() * 4);
+        for (const auto& tri : triangles) {
+            uint32_t ab = midpoint(tri[0], tri[1]);
+            uint32_t bc = midpoint(tri[1], tri[2]);
+            uint32_t ca = midpoint(tri[2], tri[0]);
+            refined.push_back({tri[0], ab, ca});
+            refined.push_back({tri[1], bc, ab});
+            refined.push_back({tri[2], ca, bc});
+            refined.push_back({ab, bc, ca});
+        }
+        triangles = std::move(refined);
+    }
+
+    // corners get their own vertex whenever the triangle needs a different u:
+    // across the seam (u shifted by one) or at a pole (u of the opposite edge)
+    std::map<std::pair<uint32_t, float>, uint32_t> corners;
+    for (const auto& tri : triangles) {
+        glm::vec2 uv[3];
+        for (int k = 0; k < 3; ++k) {
+            uv[k] = sphericalUV(points[tri[k]]);
+        }
+        float highest = std::max(uv[0].x, std::max(uv[1].x, uv[2].x));
+        for (int k = 0; k < 3; ++k) {
+            if (highest - uv[k].x > 0.5f) {
+                uv[k].x += 1.0f;
+            }
+        }
+        for (int k = 0; k < 3; ++k) {
+            if (std::abs(points[tri[k]].y) > 0.9999f) {
+                uv[k].x = 0.5f * (uv[(k + 1) % 3].x + uv[(k + 2) % 3].x);
+            }
+        }
+        for (int k = 0; k < 3; ++k) {
+            auto inserted = corners.emplace(std::make_pair(tri[k], uv[k].x), static_cast<uint32_t>(mesh.positions.size()));
+            if (inserted.second) {
+                addVertex(mesh, points[tri[k]], uv[k]);
+            }
+            mesh.indices.push_back(inserted.first->second);
+        }
+    }
+}
+
+// spherified cube: spreads the grid more evenly than normalizing cube points
+static glm::vec3 cubeToSphere(const glm::vec3& p) {
+    glm::vec3 squared = p * p;
+    return glm::normalize(glm::vec3(
+        p.x * std::sqrt(std::max(0.0f, 1.0f - squared.y / 2.0f - squared.z / 2.0f + squared.y * squared.z / 3.0f)),
+        p.y * std::sqrt(std::max(0.0f, 1.0f - squared.z / 2.0f - squared.x / 2.0f + squared.z * squared.x / 3.0f)),
+        p.z * std::sqrt(std::max(0.0f, 1.0f - squared.x / 2.0f - squared.y / 2.0f + squared.x * squared.y / 3.0f))
+    ));
+}
+
+static void generateCubeSphere(MeshData& mesh, int subdivisions) {
+    uint32_t cells = 1u << subdivisions;
+    const glm::vec3 faces[6][3] = {
+        // normal, right, up
+        {{1, 0, 0}, {0, 0, -1}, {0, 1, 0}},
+        {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}},
+        {{0, 1, 0}, {1, 0, 0}, {0, 0, -1}},
+        {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}},
+        {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}},
+        {{0, 0, -1}, {-1, 0, 0}, {0, 1, 0}}
+    };
+
+    // every face is its own UV chart, so nothing wraps
+    for (const auto& face : faces) {
+        uint32_t first = static_cast<uint32_t>(mesh.positions.size());
+        for (uint32_t row = 0; row <= cells; ++row) {
+            for (uint32_t column = 0; column <= cells; ++column) {
+                glm::vec2 uv(static_cast<float>(column) / cells, static_cast<float>(row) / cells);
+                glm::vec3 cube = face[0] + face[1] * (uv.x * 2.0f - 1.0f) + face[2] * (uv.y * 2.0f - 1.0f);
+                addVertex(mesh, cubeToSphere(cube), uv);
+            }
+        }
+        uint32_t stride = cells + 1;
+        for (uint32_t row = 0; row < cells; ++row) {
+            for (uint32_t column = 0; column < cells; ++column) {
+                uint32_t a = first + row * stride + column;
+                addQuad(mesh, a, a + 1, a + stride + 1, a + stride);
+            }
+        }
+    }
+}
+
+bool parseSphereKind(const std::string& name, SphereKind& kind) {
+    if (name == "uv") {
+        kind = SphereKind::UV;
+    } else if (name == "ico") {
+        kind = SphereKind::Ico;
+    } else if (name == "cube") {
+        kind = SphereKind::Cube;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+MeshData generateSphere(SphereKind kind, int subdivisions) {
+    subdivisions = std::max(0, std::min(subdivisions, MAX_SPHERE_SUBDIVISIONS));
+
+    MeshData mesh;
+    switch (kind) {
+        case SphereKind::UV:
+            generateUVSphere(mesh, subdivisions);
+            break;
+        case SphereKind::Ico:
+            generateIcoSphere(mesh, subdivisions);
+            break;
+        case SphereKind::Cube:
+            generateCubeSphere(mesh, subdivisions);
+            break;
+    }
+
+    mesh.boundsCenter = glm::vec3(0.0f);
+    mesh.boundsRadius = GENERATED_SPHERE_RADIUS;
+    buildLodChain(mesh);
+    const char* kindNames[] = {"uv", "ico", "cube"};
+    optimizeMesh(mesh, std::string(kindNames[static_cast<int>(kind)]) + " sphere, level " + std::to_string(subdivisions));
+    buildMeshlets(mesh);
+    return mesh;
+}
+
+const MeshData& generatedSphere(SphereKind kind, int subdivisions) {
+    static std::mutex cacheMutex;
+    static std::map<std::pair<SphereKind, int>, std::unique_ptr<MeshData>> cache;
+
+    subdivisions = std::max(0, std::min(subdivisions, MAX_SPHERE_SUBDIVISIONS));
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    std::unique_ptr<MeshData>& entry = cache[std::make_pair(kind, subdivisions)];
+    if (!entry) {
+        entry.reset(new MeshData(generateSphere(kind, subdivisions)));
+    }
+    return *entry;
+}
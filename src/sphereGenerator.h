@@ -0,0 +1,31 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: sphereGenerator.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "mesh.h"
+#include <string>
+
+// same size as src/objects/sphere.obj, which the fragment shaders were tuned on
+constexpr float GENERATED_SPHERE_RADIUS = 0.5f;
+constexpr int MAX_SPHERE_SUBDIVISIONS = 8;
+
+enum class SphereKind {
+    UV,    // 8 * 2^level segments by 4 * 2^level rings
+    Ico,   // 20 * 4^level triangles
+    Cube   // 6 faces of 2^level by 2^level quads
+};
+
+bool parseSphereKind(const std::string& name, SphereKind& kind);
+
+// indexed sphere with analytic normals and UVs that have duplicated seam
+// vertices instead of wrapping around, plus its LOD chain, cache optimized
+MeshData generateSphere(SphereKind kind, int subdivisions);
+
+// generated once per kind and level, then shared by every caller
+const MeshData& generatedSphere(SphereKind kind, int subdivisions);
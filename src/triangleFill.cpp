@@ -8,70 +8,267 @@ Last modification: 23/11/2023
 *Some parts were made using the AIs Bard and ChatGPT
 ------------------------------------------------------------------------------*/
 #include "triangleFill.h"
+#include "jobSystem.h"
 #include <array>
 #include <vector>
 #include <string>
 #include <cstring>
-#include <fstream>
-#include <sstream>
+#include <charconv>
 #include <iostream>
 #include <algorithm>
 #include <glm/glm.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-bool triangleFill(const std::string& path, std::vector<glm::vec3>& out_vertices, std::vector<glm::vec3>& out_normals, std::vector<glm::vec3>& out_texcoords, std::vector<Face>& out_faces)
-{
-    std::ifstream file(path);
-    if (!file.is_open())
-    {
-        std::cout << "Failed to open the file: " << path << std::endl;
-        return false;
+// below this many bytes per chunk handing it to another thread costs more than the parse
+constexpr size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+// a face index written as a negative (relative) number can only be resolved
+// once the number of elements defined by the previous chunks is known
+struct RelativeIndex {
+    size_t face;
+    int corner;
+    int attribute; // 0 = vertex, 1 = texcoord, 2 = normal
+};
+
+struct ObjChunk {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec3> texcoords;
+    std::vector<Face> faces;
+    std::vector<RelativeIndex> relatives;
+};
+
+static const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        ++p;
     }
+    return p;
+}
 
-    std::string line;
-    while (std::getline(file, line))
-    {
-        std::istringstream iss(line);
-        std::string lineHeader;
-        iss >> lineHeader;
+static const char* readFloats(const char* p, const char* end, float* out, int count) {
+    for (int i = 0; i < count; ++i) {
+        p = skipSpaces(p, end);
+        auto result = std::from_chars(p, end, out[i]);
+        if (result.ec != std::errc()) {
+            out[i] = 0.0f;
+            continue;
+        }
+        p = result.ptr;
+    }
+    return p;
+}
 
-        if (lineHeader == "v")
-        {
+// resolves an OBJ index (1-based, or negative relative to the elements read so far)
+// into a 0-based index local to the chunk, recording relatives for the merge
+static int resolveIndex(int value, size_t localCount, ObjChunk& chunk, int corner, int attribute) {
+    if (value > 0) {
+        return value - 1;
+    }
+    if (value < 0) {
+        chunk.relatives.push_back(RelativeIndex{chunk.faces.size(), corner, attribute});
+        return static_cast<int>(localCount) + value;
+    }
+    return -1;
+}
+
+static const char* readFaceCorner(const char* p, const char* end, ObjChunk& chunk, Face& face, int corner) {
+    p = skipSpaces(p, end);
+
+    int values[3] = {0, 0, 0};
+    for (int attribute = 0; attribute < 3; ++attribute) {
+        if (p < end && *p != '/') {
+            auto result = std::from_chars(p, end, values[attribute]);
+            if (result.ec == std::errc()) {
+                p = result.ptr;
+            }
+        }
+        if (p < end && *p == '/') {
+            ++p;
+        } else {
+            break;
+        }
+    }
+
+    face.vertexIndices[corner] = resolveIndex(values[0], chunk.vertices.size(), chunk, corner, 0);
+    face.texIndices[corner] = resolveIndex(values[1], chunk.texcoords.size(), chunk, corner, 1);
+    face.normalIndices[corner] = resolveIndex(values[2], chunk.normals.size(), chunk, corner, 2);
+
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+        ++p;
+    }
+    return p;
+}
+
+static void parseChunk(const char* begin, const char* end, ObjChunk& chunk) {
+    const char* p = begin;
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (lineEnd == nullptr) {
+            lineEnd = end;
+        }
+
+        const char* headerBegin = skipSpaces(p, lineEnd);
+        const char* headerEnd = headerBegin;
+        while (headerEnd < lineEnd && *headerEnd != ' ' && *headerEnd != '\t' && *headerEnd != '\r') {
+            ++headerEnd;
+        }
+        size_t headerLength = headerEnd - headerBegin;
+
+        if (headerLength == 1 && headerBegin[0] == 'v') {
             glm::vec3 vertex;
-            iss >> vertex.x >> vertex.y >> vertex.z;
-            out_vertices.push_back(vertex);
+            readFloats(headerEnd, lineEnd, &vertex.x, 3);
+            chunk.vertices.push_back(vertex);
         }
-        else if (lineHeader == "vn")
-        {
+        else if (headerLength == 2 && headerBegin[0] == 'v' && headerBegin[1] == 'n') {
             glm::vec3 normal;
-            iss >> normal.x >> normal.y >> normal.z;
-            out_normals.push_back(normal);
+            readFloats(headerEnd, lineEnd, &normal.x, 3);
+            chunk.normals.push_back(normal);
         }
-        else if (lineHeader == "vt")
-        {
+        else if (headerLength == 2 && headerBegin[0] == 'v' && headerBegin[1] == 't') {
             glm::vec3 tex;
-            iss >> tex.x >> tex.y >> tex.z;
-            out_texcoords.push_back(tex);
+            readFloats(headerEnd, lineEnd, &tex.x, 3);
+            chunk.texcoords.push_back(tex);
         }
-        else if (lineHeader == "f")
-        {
+        else if (headerLength == 1 && headerBegin[0] == 'f') {
             Face face;
-            for (int i = 0; i < 3; ++i)
-            {
-                std::string faceData;
-                iss >> faceData;
+            const char* q = headerEnd;
+            for (int i = 0; i < 3; ++i) {
+                q = readFaceCorner(q, lineEnd, chunk, face, i);
+            }
+            chunk.faces.push_back(face);
+        }
 
-                std::replace(faceData.begin(), faceData.end(), '/', ' ');
+        p = lineEnd + 1;
+    }
+}
 
-                std::istringstream faceDataIss(faceData);
-                faceDataIss >> face.vertexIndices[i] >> face.texIndices[i] >> face.normalIndices[i];
+// splits [0, size) into ranges that each start right after a newline
+static std::vector<size_t> chunkBoundaries(const char* data, size_t size, size_t chunkCount) {
+    std::vector<size_t> boundaries{0};
+    for (size_t k = 1; k < chunkCount; ++k) {
+        size_t position = std::max(boundaries.back(), size * k / chunkCount);
+        const void* newline = position < size ? std::memchr(data + position, '\n', size - position) : nullptr;
+        if (newline == nullptr) {
+            break;
+        }
+        position = static_cast<const char*>(newline) - data + 1;
+        if (position > boundaries.back() && position < size) {
+            boundaries.push_back(position);
+        }
+    }
+    boundaries.push_back(size);
+    return boundaries;
+}
 
-                face.vertexIndices[i]--;
-                face.normalIndices[i]--;
-                face.texIndices[i]--;
-            }
-            out_faces.push_back(face);
+template <typename T>
+static void appendAt(std::vector<T>& out, size_t offset, const std::vector<T>& in) {
+    std::copy(in.begin(), in.end(), out.begin() + offset);
+}
+
+bool triangleFill(const std::string& path, std::vector<glm::vec3>& out_vertices, std::vector<glm::vec3>& out_normals, std::vector<glm::vec3>& out_texcoords, std::vector<Face>& out_faces, unsigned int threadCount)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cout << "Failed to open the file: " << path << std::endl;
+        return false;
+    }
+
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0)
+    {
+        std::cout << "Failed to read the file: " << path << std::endl;
+        close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(fileInfo.st_size);
+    if (size == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        std::cout << "Failed to map the file: " << path << std::endl;
+        return false;
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    const char* data = static_cast<const char*>(mapping);
+
+    if (threadCount == 0)
+    {
+        threadCount = static_cast<unsigned int>(jobSystem().threadCount());
+    }
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount, size / MIN_CHUNK_BYTES));
+
+    std::vector<size_t> boundaries = chunkBoundaries(data, size, chunkCount);
+    chunkCount = boundaries.size() - 1;
+
+    std::vector<ObjChunk> chunks(chunkCount);
+    parallelFor(chunkCount, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t k = begin; k < end; ++k)
+        {
+            parseChunk(data + boundaries[k], data + boundaries[k + 1], chunks[k]);
         }
+    });
+    munmap(mapping, size);
+
+    // prefix sums give every chunk its place in the merged arrays and the
+    // number of elements its relative indices have to be shifted by
+    std::vector<std::array<size_t, 4>> offsets(chunkCount + 1);
+    offsets[0] = {out_vertices.size(), out_texcoords.size(), out_normals.size(), out_faces.size()};
+    std::array<size_t, 3> fileOffsets{0, 0, 0};
+    std::vector<std::array<size_t, 3>> relativeBase(chunkCount);
+    for (size_t k = 0; k < chunkCount; ++k)
+    {
+        relativeBase[k] = fileOffsets;
+        fileOffsets[0] += chunks[k].vertices.size();
+        fileOffsets[1] += chunks[k].texcoords.size();
+        fileOffsets[2] += chunks[k].normals.size();
+        offsets[k + 1] = {
+            offsets[k][0] + chunks[k].vertices.size(),
+            offsets[k][1] + chunks[k].texcoords.size(),
+            offsets[k][2] + chunks[k].normals.size(),
+            offsets[k][3] + chunks[k].faces.size()
+        };
     }
 
+    out_vertices.resize(offsets[chunkCount][0]);
+    out_texcoords.resize(offsets[chunkCount][1]);
+    out_normals.resize(offsets[chunkCount][2]);
+    out_faces.resize(offsets[chunkCount][3]);
+
+    auto mergeChunk = [&](size_t k) {
+        ObjChunk& chunk = chunks[k];
+        for (const RelativeIndex& relative : chunk.relatives)
+        {
+            Face& face = chunk.faces[relative.face];
+            int shift = static_cast<int>(relativeBase[k][relative.attribute]);
+            if (relative.attribute == 0) face.vertexIndices[relative.corner] += shift;
+            else if (relative.attribute == 1) face.texIndices[relative.corner] += shift;
+            else face.normalIndices[relative.corner] += shift;
+        }
+        appendAt(out_vertices, offsets[k][0], chunk.vertices);
+        appendAt(out_texcoords, offsets[k][1], chunk.texcoords);
+        appendAt(out_normals, offsets[k][2], chunk.normals);
+        appendAt(out_faces, offsets[k][3], chunk.faces);
+    };
+
+    parallelFor(chunkCount, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t k = begin; k < end; ++k)
+        {
+            mergeChunk(k);
+        }
+    });
+
     return true;
-}
\ No newline at end of file
+}
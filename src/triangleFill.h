@@ -9,6 +9,7 @@ Last modification: 23/11/2023
 ------------------------------------------------------------------------------*/
 #pragma once
 #include <array>
+#include <string>
 #include <vector>
 #include <glm/glm.hpp>
 
@@ -24,5 +25,6 @@ bool triangleFill(
   std::vector<glm::vec3> &out_vertices,
   std::vector<glm::vec3> &out_normals,
   std::vector<glm::vec3> &out_texcoords,
-  std::vector<Face>& out_faces
+  std::vector<Face>& out_faces,
+  unsigned int threadCount = 0 // chunks, 0 = one per job system thread, 1 = serial
 );
@@ -69,6 +69,11 @@ std::vector<Fragment> line(const glm::vec3& v1, const glm::vec3& v2) {
 
 std::vector<Fragment> triangle(const Vertex& a, const Vertex& b, const Vertex& c) {
     std::vector<Fragment> fragments;
+    triangle(a, b, c, fragments);
+    return fragments;
+}
+
+void triangle(const Vertex& a, const Vertex& b, const Vertex& c, std::vector<Fragment>& fragments, size_t width, size_t height) {
     glm::vec3 A = a.position;
     glm::vec3 B = b.position;
     glm::vec3 C = c.position;
@@ -78,10 +83,14 @@ std::vector<Fragment> triangle(const Vertex& a, const Vertex& b, const Vertex& c
     float maxX = std::max(std::max(A.x, B.x), C.x);
     float maxY = std::max(std::max(A.y, B.y), C.y);
 
-    for (int y = static_cast<int>(std::ceil(minY)); y <= static_cast<int>(std::floor(maxY)); ++y) {
-        for (int x = static_cast<int>(std::ceil(minX)); x <= static_cast<int>(std::floor(maxX)); ++x) {
-            if (x < 0 || y < 0 || y > SCREEN_HEIGHT || x > SCREEN_WIDTH)
-                continue;
+    // scissor: only the part of the bounding box that is on the target is walked
+    int startX = static_cast<int>(std::max(std::ceil(minX), 0.0f));
+    int startY = static_cast<int>(std::max(std::ceil(minY), 0.0f));
+    int endX = static_cast<int>(std::min(std::floor(maxX), static_cast<float>(width - 1)));
+    int endY = static_cast<int>(std::min(std::floor(maxY), static_cast<float>(height - 1)));
+
+    for (int y = startY; y <= endY; ++y) {
+        for (int x = startX; x <= endX; ++x) {
 
             glm::ivec2 P(x, y);
             auto barycentric = barycentricCoordinates(P, A, B, C);
@@ -126,5 +135,4 @@ std::vector<Fragment> triangle(const Vertex& a, const Vertex& b, const Vertex& c
             );
         }
     }
-    return fragments;
 }
\ No newline at end of file
@@ -18,4 +18,7 @@ extern glm::vec3 L;
 
 std::pair<float, float> barycentricCoordinates(const glm::ivec2& P, const glm::vec3& A, const glm::vec3& B, const glm::vec3& C);
 std::vector<Fragment> triangle(const Vertex& a, const Vertex& b, const Vertex& c);
+// appends to fragments, so a caller can keep one buffer for every triangle;
+// pixels outside a target of width x height are left out
+void triangle(const Vertex& a, const Vertex& b, const Vertex& c, std::vector<Fragment>& fragments, size_t width = SCREEN_WIDTH, size_t height = SCREEN_HEIGHT);
 std::vector<Fragment> line(const glm::vec3& v1, const glm::vec3& v2);
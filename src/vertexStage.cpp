@@ -0,0 +1,215 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: vertexStage.cpp
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#include "vertexStage.h"
+#include "jobSystem.h"
+#include <cmath>
+#include <algorithm>
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+void TransformedVertices::resize(size_t count) {
+    for (std::vector<float>* component : {&clipX, &clipY, &clipZ, &clipW, &normalX, &normalY, &normalZ, &worldX, &worldY, &worldZ}) {
+        component->resize(count);
+    }
+}
+
+VertexStageConstants prepareVertexStage(const Uniforms& uniforms) {
+    return prepareVertexStage(uniforms.projection * uniforms.view, uniforms.model);
+}
+
+VertexStageConstants prepareVertexStage(const glm::mat4& clipFromWorld, const glm::mat4& model) {
+    VertexStageConstants constants;
+    constants.clipFromModel = clipFromWorld * model;
+    constants.worldFromModel = model;
+    constants.normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+    return constants;
+}
+
+static void transformVertex(const glm::vec3& position, const glm::vec3& normal, const VertexStageConstants& constants, TransformedVertices& out, size_t i) {
+    glm::vec4 clip = constants.clipFromModel * glm::vec4(position, 1.0f);
+    glm::vec3 world = glm::vec3(constants.worldFromModel * glm::vec4(position, 1.0f));
+    glm::vec3 transformedNormal = glm::normalize(constants.normalMatrix * normal);
+
+    out.clipX[i] = clip.x;
+    out.clipY[i] = clip.y;
+    out.clipZ[i] = clip.z;
+    out.clipW[i] = clip.w;
+    out.normalX[i] = transformedNormal.x;
+    out.normalY[i] = transformedNormal.y;
+    out.normalZ[i] = transformedNormal.z;
+    out.worldX[i] = world.x;
+    out.worldY[i] = world.y;
+    out.worldZ[i] = world.z;
+}
+
+#if defined(__AVX__)
+
+static inline __m256 multiplyAdd(__m256 a, __m256 b, __m256 c) {
+#if defined(__FMA__)
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+// loads 8 packed vec3 (24 floats) and splits them into x, y and z lanes
+static inline void loadVec3x8(const glm::vec3* source, __m256& x, __m256& y, __m256& z) {
+    const float* p = &source->x;
+    __m256 m03 = _mm256_castps128_ps256(_mm_loadu_ps(p));
+    __m256 m14 = _mm256_castps128_ps256(_mm_loadu_ps(p + 4));
+    __m256 m25 = _mm256_castps128_ps256(_mm_loadu_ps(p + 8));
+    m03 = _mm256_insertf128_ps(m03, _mm_loadu_ps(p + 12), 1);
+    m14 = _mm256_insertf128_ps(m14, _mm_loadu_ps(p + 16), 1);
+    m25 = _mm256_insertf128_ps(m25, _mm_loadu_ps(p + 20), 1);
+
+    __m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+    __m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+    x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+// row r of a column-major matrix applied to (x, y, z, w)
+static inline __m256 matrixRow(const glm::mat4& m, int r, __m256 x, __m256 y, __m256 z) {
+    __m256 result = _mm256_set1_ps(m[3][r]);
+    result = multiplyAdd(_mm256_set1_ps(m[2][r]), z, result);
+    result = multiplyAdd(_mm256_set1_ps(m[1][r]), y, result);
+    return multiplyAdd(_mm256_set1_ps(m[0][r]), x, result);
+}
+
+static inline __m256 matrixRow(const glm::mat3& m, int r, __m256 x, __m256 y, __m256 z) {
+    __m256 result = _mm256_mul_ps(_mm256_set1_ps(m[2][r]), z);
+    result = multiplyAdd(_mm256_set1_ps(m[1][r]), y, result);
+    return multiplyAdd(_mm256_set1_ps(m[0][r]), x, result);
+}
+
+// transforms 8 packed vertices, outputs are stored in TransformedVertices component order
+static inline void transformX8(const glm::vec3* positions, const glm::vec3* normals, const VertexStageConstants& constants, float* const outputs[10]) {
+    const glm::mat4& clipFromModel = constants.clipFromModel;
+    const glm::mat4& worldFromModel = constants.worldFromModel;
+    const glm::mat3& normalMatrix = constants.normalMatrix;
+    __m256 one = _mm256_set1_ps(1.0f);
+
+    __m256 px, py, pz;
+    loadVec3x8(positions, px, py, pz);
+
+    _mm256_storeu_ps(outputs[0], matrixRow(clipFromModel, 0, px, py, pz));
+    _mm256_storeu_ps(outputs[1], matrixRow(clipFromModel, 1, px, py, pz));
+    _mm256_storeu_ps(outputs[2], matrixRow(clipFromModel, 2, px, py, pz));
+    _mm256_storeu_ps(outputs[3], matrixRow(clipFromModel, 3, px, py, pz));
+
+    __m256 nx, ny, nz;
+    loadVec3x8(normals, nx, ny, nz);
+    __m256 tx = matrixRow(normalMatrix, 0, nx, ny, nz);
+    __m256 ty = matrixRow(normalMatrix, 1, nx, ny, nz);
+    __m256 tz = matrixRow(normalMatrix, 2, nx, ny, nz);
+    __m256 lengthSquared = multiplyAdd(tz, tz, multiplyAdd(ty, ty, _mm256_mul_ps(tx, tx)));
+    __m256 invLength = _mm256_div_ps(one, _mm256_sqrt_ps(lengthSquared));
+    _mm256_storeu_ps(outputs[4], _mm256_mul_ps(tx, invLength));
+    _mm256_storeu_ps(outputs[5], _mm256_mul_ps(ty, invLength));
+    _mm256_storeu_ps(outputs[6], _mm256_mul_ps(tz, invLength));
+
+    _mm256_storeu_ps(outputs[7], matrixRow(worldFromModel, 0, px, py, pz));
+    _mm256_storeu_ps(outputs[8], matrixRow(worldFromModel, 1, px, py, pz));
+    _mm256_storeu_ps(outputs[9], matrixRow(worldFromModel, 2, px, py, pz));
+}
+
+// vertices [begin, end) in batches of 8; returns where the batches stopped
+static size_t transformVerticesX8(const VertexStreams& streams, size_t begin, size_t end, const VertexStageConstants& constants, TransformedVertices& out) {
+    size_t batched = begin + (end - begin) / 8 * 8;
+    for (size_t i = begin; i < batched; i += 8) {
+        float* const outputs[10] = {
+            &out.clipX[i], &out.clipY[i], &out.clipZ[i], &out.clipW[i],
+            &out.normalX[i], &out.normalY[i], &out.normalZ[i],
+            &out.worldX[i], &out.worldY[i], &out.worldZ[i]
+        };
+        transformX8(&streams.positions[i], &streams.normals[i], constants, outputs);
+    }
+    return batched;
+}
+
+// scattered vertices are gathered into 8-wide batches and scattered back after
+static size_t transformVertexListX8(const VertexStreams& streams, Span<uint32_t> vertices, const VertexStageConstants& constants, TransformedVertices& out) {
+    glm::vec3 positions[8];
+    glm::vec3 normals[8];
+    float lanes[10][8];
+    float* const outputs[10] = {lanes[0], lanes[1], lanes[2], lanes[3], lanes[4], lanes[5], lanes[6], lanes[7], lanes[8], lanes[9]};
+    std::vector<float>* components[10] = {
+        &out.clipX, &out.clipY, &out.clipZ, &out.clipW,
+        &out.normalX, &out.normalY, &out.normalZ,
+        &out.worldX, &out.worldY, &out.worldZ
+    };
+
+    size_t batched = vertices.size() / 8 * 8;
+    for (size_t i = 0; i < batched; i += 8) {
+        for (int lane = 0; lane < 8; ++lane) {
+            positions[lane] = streams.positions[vertices[i + lane]];
+            normals[lane] = streams.normals[vertices[i + lane]];
+        }
+        transformX8(positions, normals, constants, outputs);
+        for (int c = 0; c < 10; ++c) {
+            float* component = components[c]->data();
+            for (int lane = 0; lane < 8; ++lane) {
+                component[vertices[i + lane]] = lanes[c][lane];
+            }
+        }
+    }
+    return batched;
+}
+
+#endif
+
+// vertices per job, a multiple of 8 so only the very last range has a scalar tail;
+// most draws are smaller and stay on the calling thread
+constexpr size_t VERTEX_GRAIN = 2048;
+
+void transformVertices(const VertexStreams& streams, const VertexStageConstants& constants, TransformedVertices& out) {
+    out.resize(streams.size());
+
+    parallelFor(streams.size() / VERTEX_GRAIN + 1, 1, [&](size_t firstBlock, size_t endBlock) {
+        size_t begin = firstBlock * VERTEX_GRAIN;
+        size_t end = std::min(endBlock * VERTEX_GRAIN, streams.size());
+        size_t first = begin;
+#if defined(__AVX__)
+        first = transformVerticesX8(streams, begin, end, constants, out);
+#endif
+        for (size_t i = first; i < end; ++i) {
+            transformVertex(streams.positions[i], streams.normals[i], constants, out, i);
+        }
+    });
+}
+
+void transformVertices(const VertexStreams& streams, Span<uint32_t> vertices, const VertexStageConstants& constants, TransformedVertices& out) {
+    out.resize(streams.size());
+
+    parallelFor(vertices.size() / VERTEX_GRAIN + 1, 1, [&](size_t firstBlock, size_t endBlock) {
+        size_t begin = firstBlock * VERTEX_GRAIN;
+        Span<uint32_t> range = vertices.subspan(begin, std::min(endBlock * VERTEX_GRAIN, vertices.size()) - begin);
+        size_t first = 0;
+#if defined(__AVX__)
+        first = transformVertexListX8(streams, range, constants, out);
+#endif
+        for (size_t i = first; i < range.size(); ++i) {
+            uint32_t index = range[i];
+            transformVertex(streams.positions[index], streams.normals[index], constants, out, index);
+        }
+    });
+}
+
+void projectToClip(Span<uint32_t> vertices, const glm::mat4& clipFromWorld, TransformedVertices& out) {
+    for (uint32_t index : vertices) {
+        glm::vec4 clip = clipFromWorld[0] * out.worldX[index] + clipFromWorld[1] * out.worldY[index] + clipFromWorld[2] * out.worldZ[index] + clipFromWorld[3];
+        out.clipX[index] = clip.x;
+        out.clipY[index] = clip.y;
+        out.clipZ[index] = clip.z;
+        out.clipW[index] = clip.w;
+    }
+}
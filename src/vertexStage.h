@@ -0,0 +1,53 @@
+/*---------------------------------------------------------------------------
+Copyright (C), 2022-2023, Sara Echeverria (bl33h)
+@author Sara Echeverria
+FileName: vertexStage.h
+@version: I
+Creation: 18/10/2026
+Last modification: 18/10/2026
+*Some parts were made using the AIs Bard and ChatGPT
+------------------------------------------------------------------------------*/
+#pragma once
+#include "mesh.h"
+#include "fragment.h"
+#include <vector>
+#include <glm/glm.hpp>
+
+// everything the vertex stage needs that only changes once per draw
+struct VertexStageConstants {
+    glm::mat4 clipFromModel;    // projection * view * model
+    glm::mat4 worldFromModel;   // model
+    glm::mat3 normalMatrix;     // inverse transpose of the model's upper 3x3
+};
+
+// vertex stage outputs, one array per component so they can be written 8 at a time;
+// positions stay in clip space so primitive assembly can clip before the divide
+struct TransformedVertices {
+    std::vector<float> clipX, clipY, clipZ, clipW;
+    std::vector<float> normalX, normalY, normalZ;
+    std::vector<float> worldX, worldY, worldZ;
+
+    void resize(size_t count);
+    size_t size() const { return clipX.size(); }
+
+    glm::vec4 clip(size_t i) const { return glm::vec4(clipX[i], clipY[i], clipZ[i], clipW[i]); }
+    glm::vec3 normal(size_t i) const { return glm::vec3(normalX[i], normalY[i], normalZ[i]); }
+    glm::vec3 world(size_t i) const { return glm::vec3(worldX[i], worldY[i], worldZ[i]); }
+};
+
+VertexStageConstants prepareVertexStage(const Uniforms& uniforms);
+
+// for many draws sharing one camera: clipFromWorld is projection * view
+VertexStageConstants prepareVertexStage(const glm::mat4& clipFromWorld, const glm::mat4& model);
+
+// transforms every vertex in the streams; positions and normals are the only
+// attributes read, texcoords are passed through later by primitive assembly
+void transformVertices(const VertexStreams& streams, const VertexStageConstants& constants, TransformedVertices& out);
+
+// transforms only the listed vertices, leaving the outputs of the others
+// untouched; each output lands at its vertex index
+void transformVertices(const VertexStreams& streams, Span<uint32_t> vertices, const VertexStageConstants& constants, TransformedVertices& out);
+
+// the clip positions of the listed vertices for another camera, from the world
+// positions already in out; normals and world positions don't depend on the view
+void projectToClip(Span<uint32_t> vertices, const glm::mat4& clipFromWorld, TransformedVertices& out);